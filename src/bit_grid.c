@@ -0,0 +1,86 @@
+#include "includes.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif // _MSC_VER
+
+// Amount of bits set on a word
+static inline size_t popcount64(uint64_t word)
+{
+    #ifdef _MSC_VER
+    return __popcnt64(word);
+    #else
+    return __builtin_popcountll(word);
+    #endif // _MSC_VER
+}
+
+// Bits of a word that are inside a range of spaces (both included)
+// 'word' is the position of the word on the grid.
+static inline uint64_t range_mask(size_t word, size_t first, size_t last)
+{
+    const size_t word_first = word * 64;
+    const size_t lo = (first > word_first) ? first - word_first : 0;
+    const size_t hi = (last < word_first + 63) ? last - word_first : 63;
+    const uint64_t upper = (hi == 63) ? UINT64_MAX : ((UINT64_C(1) << (hi + 1)) - 1);
+    return upper & ~((UINT64_C(1) << lo) - 1);
+}
+
+// Allocate the memory for a grid of the given size, with all spaces free
+void grid_init(BitGrid *grid, size_t rows, size_t cols)
+{
+    if (rows == 0 || cols == 0)
+    {
+        printf_error_exit(ERR_INVALID_ARGS, "Grid must not have an width or a height of zero.");
+    }
+
+    grid->rows = rows;
+    grid->cols = cols;
+    grid->stride = (cols + 63) / 64 * 64;
+
+    grid->words = xmalloc_aligned(sizeof(uint64_t) * (grid->stride / 64) * rows);
+}
+
+// Whether a space of the grid is occupied
+extern inline bool grid_get(const BitGrid *grid, size_t cell)
+{
+    return (grid->words[cell / 64] >> (cell % 64)) & 1;
+}
+
+// Flag a space of the grid as occupied
+extern inline void grid_set(BitGrid *grid, size_t cell)
+{
+    grid->words[cell / 64] |= UINT64_C(1) << (cell % 64);
+}
+
+// Flag a space of the grid as free
+extern inline void grid_clear(BitGrid *grid, size_t cell)
+{
+    grid->words[cell / 64] &= ~(UINT64_C(1) << (cell % 64));
+}
+
+// Flag as occupied a range of spaces on the same row (from 'first' to 'last', both included)
+void grid_set_run(BitGrid *grid, size_t first, size_t last)
+{
+    for (size_t i = first / 64; i <= last / 64; i++)
+    {
+        grid->words[i] |= range_mask(i, first, last);
+    }
+}
+
+// Count the free spaces on a range of the same row (from 'first' to 'last', both included)
+size_t grid_count_free(const BitGrid *grid, size_t first, size_t last)
+{
+    size_t count = 0;
+    for (size_t i = first / 64; i <= last / 64; i++)
+    {
+        count += popcount64(~grid->words[i] & range_mask(i, first, last));
+    }
+    return count;
+}
+
+// Free the memory used by a grid
+void grid_free(BitGrid *grid)
+{
+    free_aligned(grid->words);
+    grid->words = NULL;
+}
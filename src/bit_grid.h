@@ -0,0 +1,35 @@
+// Collision grid with one bit per space, indexed by the spaces' linear index
+
+#pragma once
+
+#include "includes.h"
+
+// Grid with one bit per space
+typedef struct BitGrid
+{
+    uint64_t *words;    // Bits of the spaces, row by row ('1' means an occupied space)
+    size_t rows;        // Amount of rows
+    size_t cols;        // Amount of columns
+    size_t stride;      // Difference between the indices of vertically adjacent spaces (columns rounded up to a multiple of 64)
+} BitGrid;
+
+// Allocate the memory for a grid of the given size, with all spaces free
+void grid_init(BitGrid *grid, size_t rows, size_t cols);
+
+// Whether a space of the grid is occupied
+inline bool grid_get(const BitGrid *grid, size_t cell);
+
+// Flag a space of the grid as occupied
+inline void grid_set(BitGrid *grid, size_t cell);
+
+// Flag a space of the grid as free
+inline void grid_clear(BitGrid *grid, size_t cell);
+
+// Flag as occupied a range of spaces on the same row (from 'first' to 'last', both included)
+void grid_set_run(BitGrid *grid, size_t first, size_t last);
+
+// Count the free spaces on a range of the same row (from 'first' to 'last', both included)
+size_t grid_count_free(const BitGrid *grid, size_t first, size_t last);
+
+// Free the memory used by a grid
+void grid_free(BitGrid *grid);
@@ -0,0 +1,221 @@
+#include "includes.h"
+
+// Free the boards, but not the arrays that hold them
+static void demo_free_boards(DemoState *demo)
+{
+    for (size_t i = 0; i < demo->count; i++)
+    {
+        board_free(&demo->boards[i]);
+        render_free(&demo->renders[i]);
+    }
+}
+
+// Start a new game on a board, after erasing the previous one
+static void demo_restart(DemoState *demo, GameState *board)
+{
+    erase_game(board);
+    board_free(board);
+    board_init(board);
+    demo->restarts++;
+}
+
+// Set-up the attract mode on the screen of the given game state, with the amount of boards from its options
+// The terminal must already be set-up by game_init(). Program exits if the boards do not fit on the terminal.
+void demo_init(GameState *state)
+{
+    state->demo = xmalloc(sizeof(DemoState));
+
+    const size_t count = state->options.demo_boards;
+    if (!demo_layout(state, count) || state->demo->count < count)
+    {
+        const size_t board_size = 2 * (SCREEN_MARGIN + SNAKE_START_SIZE + 1) + 1;
+        printf_error_exit(
+            ERR_TINY_TERMINAL,
+            "Terminal's size is too small for %zu boards, each board needs at least %zu by %zu characters.",
+            count, board_size, board_size
+        );
+    }
+}
+
+// Divide the screen among the boards, then start a new game on each of them and draw everything
+// If the screen is too small for all boards, less boards are shown (this is meant for after the terminal was resized).
+// Returns 'false' if not even a single board fits on the screen.
+bool demo_layout(GameState *state, size_t count)
+{
+    DemoState *demo = state->demo;
+    ScreenBuffer *screen = state->screen;
+    const size_t board_size = 2 * (SCREEN_MARGIN + SNAKE_START_SIZE + 1) + 1; // Minimum rows and columns of a board
+
+    // Pick the amount of rows and columns of boards that makes the boards the biggest
+    // (the terminal's characters are about twice as tall as they are wide, so a row counts as two columns)
+    GameCoord grid = {0, 0};
+    size_t best_score = 0;
+    while (count > 0)
+    {
+        for (size_t cols = 1; cols <= count; cols++)
+        {
+            const size_t rows = (count + cols - 1) / cols;
+            const GameCoord size = {screen->rows / rows, screen->cols / cols};
+            if (size.row < board_size || size.col < board_size) continue;
+
+            const size_t score = (size.row * 2 < size.col) ? size.row * 2 : size.col;
+            if (score > best_score)
+            {
+                best_score = score;
+                grid = (GameCoord){rows, cols};
+            }
+        }
+
+        if (grid.row > 0) break;
+        count--;    // Try again with one less board
+    }
+
+    // Replace the previous boards
+    demo_free_boards(demo);
+    if (count == 0)
+    {
+        demo->count = 0;
+        return false;
+    }
+
+    if (count > demo->count)
+    {
+        free_aligned(demo->boards);
+        free(demo->viewports);
+        free(demo->backends);
+        free(demo->renders);
+        demo->boards = xmalloc_aligned(sizeof(typeof(*demo->boards)) * count);
+        demo->viewports = xmalloc(sizeof(typeof(*demo->viewports)) * count);
+        demo->backends = xmalloc(sizeof(typeof(*demo->backends)) * count);
+        demo->renders = xmalloc(sizeof(typeof(*demo->renders)) * count);
+    }
+    demo->count = count;
+    demo->grid = grid;
+
+    const GameCoord viewport_size = {screen->rows / grid.row, screen->cols / grid.col};
+
+    for (size_t i = 0; i < count; i++)
+    {
+        // Region of the screen of the board
+        RenderViewport *viewport = &demo->viewports[i];
+        *viewport = (RenderViewport){
+            .screen = screen,
+            .origin = {(i / grid.col) * viewport_size.row + 1, (i % grid.col) * viewport_size.col + 1},
+            .size = viewport_size,
+        };
+
+        render_init(&demo->renders[i]);
+        demo->backends[i] = render_backend_viewport(viewport);
+
+        // Each board is a game that takes the whole viewport
+        GameState *board = &demo->boards[i];
+        *board = (GameState){
+            .screen = screen,
+            .render = &demo->renders[i],
+            .backend = &demo->backends[i],
+            .screen_size = viewport_size,
+            .origin = viewport->origin,
+            .options = state->options,
+            .has_focus = true,
+        };
+
+        draw_board_frame(board);
+        board_init(board);
+        render_submit(board->render, board->backend, false);
+    }
+
+    // All boards move at the speed of a new game
+    demo->tick_time = demo->boards[0].tick_time_start;
+
+    // Output everything at once
+    screen_redraw(screen);
+    screen_flush(screen, true);
+
+    return true;
+}
+
+// MAIN LOOP of the attract mode: move all boards with the autopilot, then draw them in a single flush
+// The loop ends when a key is pressed.
+void demo_mainloop(GameState *state)
+{
+    DemoState *demo = state->demo;
+    uint64_t deadline = clock_usec() + demo->tick_time;
+    arm_timer(deadline);
+
+    // Whether the changes of the current frame are drawn (they are not while catching up with missed deadlines)
+    bool draw = true;
+
+    while (true)
+    {
+        // Wait for the next frame, while taking the input and the signals as soon as they arrive
+        unsigned int events = 0;
+        while (!(events & EVENT_TIMER))
+        {
+            events = wait_event(true);
+
+            // Divide the screen again if the terminal was resized, then keep waiting for the same deadline
+            if ((events & EVENT_SIGNAL) && terminal_resized()) game_resize(state);
+
+            // Any key ends the attract mode, except for the focus reports (losing focus pauses it instead)
+            // (a lone ESC is only told apart from a sequence after a while, so it is checked again on the next events)
+            if (events & EVENT_INPUT)
+            {
+                const size_t keys = state->input->keys;
+                parse_input(state);
+                if (state->input->keys != keys) return;
+                if (!state->has_focus)
+                {
+                    game_suspend(state);
+                    deadline = clock_usec();
+                    break;
+                }
+            }
+            if (input_escape(state->input)) return;
+        }
+
+        for (size_t i = 0; i < demo->count; i++)
+        {
+            GameState *board = &demo->boards[i];
+            const SnakeDirection dir = autopilot(board);
+
+            // The board starts over when the autopilot has no way out, instead of letting the snake collide
+            // (so the collided head is not drawn over the walls)
+            const GameCell next = board->position + board->dir_step[dir];
+            if (grid_get(&board->arena, next) && next != board->snake[board->tail])
+            {
+                demo_restart(demo, board);
+            }
+            else
+            {
+                move_snake(board, dir);
+                if (board->free_area == 0) demo_restart(demo, board);
+            }
+
+            // The changes are only written to the screen buffer
+            render_submit(board->render, board->backend, false);
+        }
+
+        // Draw the changes of all boards at once
+        // (unless the terminal is lagging behind, or the boards are catching up with missed deadlines,
+        // in which case the changes are merged into the next frame)
+        if (draw) screen_flush(state->screen, false);
+
+        // Schedule the next frame
+        draw = schedule_next_tick(state, &deadline, demo->tick_time);
+    }
+}
+
+// Free the memory used by the boards of the attract mode
+void demo_free(GameState *state)
+{
+    DemoState *demo = state->demo;
+    if (!demo) return;
+
+    demo_free_boards(demo);
+    free_aligned(demo->boards);
+    free(demo->viewports);
+    free(demo->backends);
+    free(demo->renders);
+    free(demo);
+    state->demo = NULL;
+}
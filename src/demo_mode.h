@@ -0,0 +1,34 @@
+// Attract mode: several boards played by the autopilot, each one on its own region of the screen
+
+#pragma once
+
+#include "includes.h"
+
+// Boards being shown on the attract mode
+typedef struct DemoState
+{
+    GameState *boards;          // (array) Game state of each board
+    RenderViewport *viewports;  // (array) Region of the screen where each board is drawn
+    RenderBackend *backends;    // (array) Backend of each board, drawing to its viewport
+    RenderList *renders;        // (array) Draw commands of each board
+    size_t count;               // Amount of boards
+    GameCoord grid;             // Amount of rows and columns of boards on the screen
+    uint64_t tick_time;         // Duration (in microseconds) of each frame (all boards move at the same speed)
+    uint64_t restarts;          // Amount of times that a board started over (after getting stuck or being filled)
+} DemoState;
+
+// Set-up the attract mode on the screen of the given game state, with the amount of boards from its options
+// The terminal must already be set-up by game_init(). Program exits if the boards do not fit on the terminal.
+void demo_init(GameState *state);
+
+// Divide the screen among the boards, then start a new game on each of them and draw everything
+// If the screen is too small for all boards, less boards are shown (this is meant for after the terminal was resized).
+// Returns 'false' if not even a single board fits on the screen.
+bool demo_layout(GameState *state, size_t count);
+
+// MAIN LOOP of the attract mode: move all boards with the autopilot, then draw them in a single flush
+// The loop ends when a key is pressed.
+void demo_mainloop(GameState *state);
+
+// Free the memory used by the boards of the attract mode
+void demo_free(GameState *state);
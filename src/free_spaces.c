@@ -0,0 +1,62 @@
+#include "includes.h"
+
+// Create the lists for a board with the given amount of spaces, with all spaces occupied
+// (the spaces where the food pellet can go are then added with spaces_release())
+FreeSpaces* spaces_create(size_t cell_count)
+{
+    FreeSpaces *free_spaces = xmalloc(sizeof(FreeSpaces));
+    free_spaces->spaces = xmalloc(sizeof(typeof(*free_spaces->spaces)) * cell_count);
+    free_spaces->slots = xmalloc(sizeof(typeof(*free_spaces->slots)) * cell_count);
+    free_spaces->count = 0;
+
+    for (size_t i = 0; i < cell_count; i++)
+    {
+        free_spaces->slots[i] = SPACE_TAKEN;
+    }
+
+    return free_spaces;
+}
+
+// Remove a space from the empty spaces
+// Note: nothing happens if the space is already occupied.
+extern inline void spaces_occupy(FreeSpaces *free_spaces, GameCell cell)
+{
+    const uint32_t slot = free_spaces->slots[cell];
+    if (slot == SPACE_TAKEN) return;
+
+    // Move the last empty space to the slot being vacated
+    const GameCell last = free_spaces->spaces[--free_spaces->count];
+    free_spaces->spaces[slot] = last;
+    free_spaces->slots[last] = slot;
+    free_spaces->slots[cell] = SPACE_TAKEN;
+}
+
+// Add a space to the empty spaces
+// Note: nothing happens if the space is already empty.
+extern inline void spaces_release(FreeSpaces *free_spaces, GameCell cell)
+{
+    if (free_spaces->slots[cell] != SPACE_TAKEN) return;
+
+    free_spaces->spaces[free_spaces->count] = cell;
+    free_spaces->slots[cell] = (uint32_t)free_spaces->count++;
+}
+
+// Empty space at the given position of the array (from zero to .count minus one)
+GameCell spaces_get(const FreeSpaces *free_spaces, size_t index)
+{
+    if (index >= free_spaces->count)
+    {
+        printf_error_exit(ERR_ARRAY_OVERFLOW, "Tried to access an out-of-bounds coordinate.");
+    }
+
+    return free_spaces->spaces[index];
+}
+
+// Free the memory used by the lists
+void spaces_destroy(FreeSpaces *free_spaces)
+{
+    if (!free_spaces) return;
+    free(free_spaces->spaces);
+    free(free_spaces->slots);
+    free(free_spaces);
+}
@@ -0,0 +1,33 @@
+// List of the empty spaces of the board, for picking a random one in constant time
+
+#pragma once
+
+#include "includes.h"
+
+#define SPACE_TAKEN UINT32_MAX  // Value on the map of the spaces that are not on the array (the occupied spaces)
+
+// Empty spaces of the board
+typedef struct FreeSpaces
+{
+    GameCell *spaces;   // (array) Each empty space
+    uint32_t *slots;    // (array) Position on .spaces[] of each space of the board, or SPACE_TAKEN if it is occupied
+    size_t count;       // Amount of empty spaces
+} FreeSpaces;
+
+// Create the lists for a board with the given amount of spaces, with all spaces occupied
+// (the spaces where the food pellet can go are then added with spaces_release())
+FreeSpaces* spaces_create(size_t cell_count);
+
+// Remove a space from the empty spaces
+// Note: nothing happens if the space is already occupied.
+inline void spaces_occupy(FreeSpaces *free_spaces, GameCell cell);
+
+// Add a space to the empty spaces
+// Note: nothing happens if the space is already empty.
+inline void spaces_release(FreeSpaces *free_spaces, GameCell cell);
+
+// Empty space at the given position of the array (from zero to .count minus one)
+GameCell spaces_get(const FreeSpaces *free_spaces, size_t index);
+
+// Free the memory used by the lists
+void spaces_destroy(FreeSpaces *free_spaces);
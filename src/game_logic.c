@@ -1,162 +1,126 @@
 #include "includes.h"
 
+// Shorthands for the tables below
+#define BODY(glyph) CELL_INIT(glyph, CELL_GREEN)
+#define BAD_BODY BODY(SNAKE_UNKNOWN)
+
+// Body part drawn where the snake's head was, indexed by [old direction][new direction]
+// (the directions that would make the snake to go backwards are never used, because they get corrected beforehand)
+const ScreenCell snake_body_cells[DIR_COUNT][DIR_COUNT] = {
+    [DIR_NONE] = {
+        [DIR_NONE] = BAD_BODY, [DIR_UP] = BAD_BODY, [DIR_DOWN] = BAD_BODY,
+        [DIR_RIGHT] = BAD_BODY, [DIR_LEFT] = BAD_BODY,
+    },
+    [DIR_UP] = {
+        [DIR_NONE] = BAD_BODY, [DIR_UP] = BODY(SNAKE_VERTICAL), [DIR_DOWN] = BAD_BODY,
+        [DIR_RIGHT] = BODY(SNAKE_TOP_LEFT), [DIR_LEFT] = BODY(SNAKE_TOP_RIGHT),
+    },
+    [DIR_DOWN] = {
+        [DIR_NONE] = BAD_BODY, [DIR_UP] = BAD_BODY, [DIR_DOWN] = BODY(SNAKE_VERTICAL),
+        [DIR_RIGHT] = BODY(SNAKE_BOTTOM_LEFT), [DIR_LEFT] = BODY(SNAKE_BOTTOM_RIGHT),
+    },
+    [DIR_RIGHT] = {
+        [DIR_NONE] = BAD_BODY, [DIR_UP] = BODY(SNAKE_BOTTOM_RIGHT), [DIR_DOWN] = BODY(SNAKE_TOP_RIGHT),
+        [DIR_RIGHT] = BODY(SNAKE_HORIZONTAL), [DIR_LEFT] = BAD_BODY,
+    },
+    [DIR_LEFT] = {
+        [DIR_NONE] = BAD_BODY, [DIR_UP] = BODY(SNAKE_BOTTOM_LEFT), [DIR_DOWN] = BODY(SNAKE_TOP_LEFT),
+        [DIR_RIGHT] = BAD_BODY, [DIR_LEFT] = BODY(SNAKE_HORIZONTAL),
+    },
+};
+
+// Snake's head, indexed by [has collided][direction]
+// (the head is green normally, and red in case of collision)
+const ScreenCell snake_head_cells[2][DIR_COUNT] = {
+    [false] = {
+        [DIR_NONE] = CELL_INIT(SNAKE_UNKNOWN, CELL_GREEN),
+        [DIR_UP] = CELL_INIT(SNAKE_HEAD_UP, CELL_GREEN),
+        [DIR_DOWN] = CELL_INIT(SNAKE_HEAD_DOWN, CELL_GREEN),
+        [DIR_RIGHT] = CELL_INIT(SNAKE_HEAD_RIGHT, CELL_GREEN),
+        [DIR_LEFT] = CELL_INIT(SNAKE_HEAD_LEFT, CELL_GREEN),
+    },
+    [true] = {
+        [DIR_NONE] = CELL_INIT(SNAKE_UNKNOWN, CELL_RED),
+        [DIR_UP] = CELL_INIT(SNAKE_HEAD_UP, CELL_RED),
+        [DIR_DOWN] = CELL_INIT(SNAKE_HEAD_DOWN, CELL_RED),
+        [DIR_RIGHT] = CELL_INIT(SNAKE_HEAD_RIGHT, CELL_RED),
+        [DIR_LEFT] = CELL_INIT(SNAKE_HEAD_LEFT, CELL_RED),
+    },
+};
+
+#undef BODY
+#undef BAD_BODY
+
+// Space of the board at the given coordinate
+extern inline GameCell board_cell(const GameState *state, GameCoord pos)
+{
+    return (GameCell)((pos.row - 1) * state->arena.stride + (pos.col - 1));
+}
+
+// Coordinate of a space of the board (this is for drawing it)
+extern inline GameCoord board_coord(const GameState *state, GameCell cell)
+{
+    return (GameCoord){
+        .row = cell / state->arena.stride + 1,
+        .col = cell % state->arena.stride + 1,
+    };
+}
+
+// Index of the snake's queue where the part after the given one is (going from the head towards the tail)
+extern inline size_t snake_next(const GameState *state, size_t sid)
+{
+    return (sid < state->snake_capacity - 1) ? sid + 1 : 0;
+}
+
+// Double the capacity of the snake's queue
+// The parts from the head to the end of the buffer are moved to the end of the new buffer, so the queue stays in order.
+static void snake_grow(GameState *state)
+{
+    const size_t old_capacity = state->snake_capacity;
+    state->snake_capacity *= 2;
+    state->snake = realloc(state->snake, sizeof(typeof(*state->snake)) * state->snake_capacity);
+    if (!state->snake)
+    {
+        printf_error_exit(ERR_NO_MEMORY, "Not enough memory.");
+    }
+
+    // The queue wraps around the end of the buffer if the tail comes before the head
+    // (when it does not, all parts are already in order at the start of the buffer)
+    if (state->tail < state->head)
+    {
+        const size_t head_count = old_capacity - state->head;
+        const size_t new_head = state->snake_capacity - head_count;
+        memmove(&state->snake[new_head], &state->snake[state->head], sizeof(typeof(*state->snake)) * head_count);
+        state->head = new_head;
+    }
+}
+
 // Spawn a food pellet at a random empty space
 void spawn_food(GameState *state)
 {
     // Return if there are no empty spaces for the food to be spawned
-    if (state->free_area == 0)
+    if (state->free_spaces->count == 0)
     {
-        state->food = (GameCoord){(size_t)-1, (size_t)-1};
+        state->food = NO_CELL;
         return;
     }
     
     // Randomly pick one of then open spaces
-    size_t random_id = xrand() % state->free_area;
-
-    // Current position
-    size_t row = state->position_min.row - 1;
-    size_t col = state->position_min.col - 1;
-    
-    // Minimum and maximum positions
-    const size_t col_start = col;
-    const size_t row_max = state->position_max.row - 1;
-    const size_t col_max = state->position_max.col - 1;
+    // (the list of empty spaces is kept up to date as the snake moves, so there is no need to search for them)
+    state->food = spaces_get(state->free_spaces, xrand() % state->free_spaces->count);
 
-    // Collision grid ('false' means an empty space)
-    bool** arena = state->arena;
-    
-    // Index counter for the empty space where the food will end up
-    size_t food_id = 0;
-    
-    // Count the empty spaces on the grid in order to find the randomly chosen space
-    // Note: this loop is going to run at least once, even if 'random_id' is zero.
-    //       It's going to run up to 'state->free_area' times.
-    while (true)
-    {
-        // Check if we are still inside the snake's area
-        if (row > row_max)
-        {
-            printf_error_exit(ERR_ARRAY_OVERFLOW, "Tried to access an out-of-bounds coordinate.");
-        }
-        
-        if (!arena[row][col])
-        {
-            // Increment the count if the current space is empty
-            food_id++;
-            if (food_id > random_id) break;
-        }
-        
-        // Moving to the next space
-        if (col < col_max)
-        {
-            // Go to the next column
-            col++;
-        }
-        else
-        {
-            // Go to the next row if at the end of a column
-            col = col_start;
-            row++;
-        }
-    }
-    
-    // Put the food pellet at the chosen position
-    // Note: the arena[] array is 0-indexed, while the terminal's coordinate is 1-indexed.
-    state->food = (GameCoord){
-        .row = row + 1,
-        .col = col + 1,
-    };
-    
-    printf(
-        MOVE_CURSOR(%zu,%zu) TEXT_YELLOW FOOD_PELLET,
-        state->food.row, state->food.col
-    );
+    render_cell(state->render, board_coord(state, state->food), CELL(FOOD_PELLET, CELL_YELLOW));
 }
 
 // Get which direction the user has pressed
+// The input that is available is read all at once, then decoded (see input_buffer.h). This never waits for more input.
 SnakeDirection parse_input(GameState* state)
 {
-    SnakeDirection dir = DIR_NONE;
-    
-    int my_char = 0;
-    while (my_char != EOF)
-    {
-        my_char = getchar_nb();
-        
-        // Keep reading the input stream until we find the sequence "ESC O"
-        // (ESC character followed by the letter O character)
-        // Or a sequence that is in the `state->keymap` trie
-        
-        if (my_char == '\x1b')  // Check if an arrow key was pressed
-        {
-            my_char = getchar();
-            if (my_char != 'O') continue;
-            my_char = getchar();
-
-            /* Note: The program locks waiting for input in case the user press the ESC key.
-            This was an oversight on the above code, but I am keeping it as a "pause" feature
-            because I really liked it :-)
-            */
-
-            // The next character after the sequence tells us which direction was pressed
-            switch (my_char)
-            {
-                case 'A':
-                    dir = DIR_UP;
-                    goto parsing_done;
-                
-                case 'B':
-                    dir = DIR_DOWN;
-                    goto parsing_done;
-                
-                case 'C':
-                    dir = DIR_RIGHT;
-                    goto parsing_done;
-                
-                case 'D':
-                    dir = DIR_LEFT;
-                    goto parsing_done;
-                
-                default:
-                    continue;
-            }
-        }
-        else if (state && state->keymap)    // Check if a mapped character key was pressed
-        {
-            if (my_char < 0 || my_char > 255) continue;
-            KeyMap *node = state->keymap->next[my_char];    // Start from the trie's root
-            
-            // Check if the byte sequence match any of the sequences in `state->keymap`
-            while (node != NULL)
-            {
-                if (node->dir != DIR_NONE)
-                {
-                    // The byte sequence was found
-                    dir = node->dir;
-                    goto parsing_done;
-                }
-                else
-                {
-                    // Get the next byte in the sequence
-                    my_char = getchar();
-                    if (my_char >= 0 && my_char <= 255)
-                    {
-                        // Move to the trie's next node
-                        node = node->next[my_char];
-                    }
-                    else
-                    {
-                        node = NULL;
-                    }
-                }
-            }
-        }
-    }
-    
-    parsing_done:
-    
-    // Flush the remaining input
-    flush_stdin();
+    input_read(state->input);
+    const SnakeDirection dir = input_parse(state->input, state->keymap, &state->has_focus);
+
+    // Discard the remaining input once a direction was found
+    if (dir != DIR_NONE) input_discard(state->input);
     /* Note: If the user keeps the key pressed, a lot of inputs might get buffered.
        Parsing that input could slow down the program, and it is not really
        necessary to process them once we already got a direction. */
@@ -176,49 +140,56 @@ bool move_snake(GameState* state, SnakeDirection dir)
     // Bend the snake's body to the new direction
     snake_turning(state, dir);
     
-    // Move the snake's head to the new coordinate
-    move_coord(&state->position, dir, 1);
-    const size_t my_row = state->position.row;
-    const size_t my_col = state->position.col;
+    // Move the snake's head to the next space
+    state->position += state->dir_step[dir];
+    const GameCell head = state->position;
     
-    // Coordinate of the snake's tail
-    const GameCoord tail = state->snake[state->tail];
+    // Space of the snake's tail
+    const GameCell tail = state->snake[state->tail];
     
     // Check if the snake hit an wall or itself
     // (do not collide with the tail because it is moving away from its current position)
-    const bool has_collided = state->arena[my_row-1][my_col-1] && (my_row != tail.row || my_col != tail.col);
+    const bool has_collided = grid_get(&state->arena, head) && (head != tail);
 
     // Check if a food pellet was obtained
-    const bool got_food = (state->food.row == my_row) && (state->food.col == my_col);
+    const bool got_food = (state->food == head);
 
     // Flag the new head's position as occupied
-    state->arena[my_row-1][my_col-1] = true;
+    grid_set(&state->arena, head);
+    spaces_occupy(state->free_spaces, head);
 
     // Push the new head's coordinate into the start of the queue
-    state->head = (state->head > 0) ? state->head - 1 : state->total_area - 1; // Wrap around the buffer
-    state->snake[state->head] = state->position;
+    // (the queue holds one more part than the snake's size until the tail is popped, so it grows before getting full)
+    if (state->size + 1 > state->snake_capacity) snake_grow(state);
+    state->head = (state->head > 0) ? state->head - 1 : state->snake_capacity - 1; // Wrap around the buffer
+    state->snake[state->head] = head;
 
     // Pop the snake's tail from the end of the queue if no food was obtained
     if (!got_food)
     {
         // Flag the old tail's position as empty
-        const GameCoord pos = state->snake[state->tail];
-        state->arena[pos.row-1][pos.col-1] = false;
+        // (unless the head has just moved into it)
+        if (tail != head)
+        {
+            grid_clear(&state->arena, tail);
+            spaces_release(state->free_spaces, tail);
+        }
 
         // Delete the tail's end from the screen
-        printf(MOVE_CURSOR(%zu,%zu) " ", pos.row, pos.col);
+        render_cell(state->render, board_coord(state, tail), CELL(" ", CELL_GRAY));
 
         // Remove the old coordinate from the queue
-        state->tail = (state->tail > 0) ? state->tail - 1 : state->total_area -1;  // Wrap around the buffer
+        state->tail = (state->tail > 0) ? state->tail - 1 : state->snake_capacity - 1;  // Wrap around the buffer
     }
     else
     {
-        // Generate a new food pellet after one was eaten
-        spawn_food(state);
-        
         // There is one less empty space since the snake has grown
+        // (this needs to be updated before spawning the food, so the head's space is not counted as empty)
         state->free_area -= 1;
 
+        // Generate a new food pellet after one was eaten
+        spawn_food(state);
+
         // The snake grows when getting the food pellet
         state->size += 1;
 
@@ -230,15 +201,6 @@ bool move_snake(GameState* state, SnakeDirection dir)
     // (it is being drawn last in order to avoid being cleared in case the head ends up in the tail's old position)
     draw_snake_head(state, has_collided);
 
-    fflush(stdout);
-
-    #ifdef _WIN32
-    // On Windows, this prevents events other than key presses from cluttering the input buffer.
-    // This is needed because we are checking the event count in order to determine if there's a key to be parsed.
-    // We do not really need to handle those other events on this program.
-    FlushConsoleInputBuffer(state->input_handle);
-    #endif
-
     return has_collided;
 }
 
@@ -270,153 +232,150 @@ extern inline void correct_direction(GameState* state, SnakeDirection* new_dir)
     }
 }
 
-// Bend the snake's body to the direction it is turning to.
-// (this function draws the appropriate shape on the point the snake bent)
-void snake_turning(GameState* state, SnakeDirection new_dir)
+// Pick a direction that moves the snake towards the food pellet, while avoiding a collision on the next move
+// (this is for moving the snake without a player)
+SnakeDirection autopilot(GameState *state)
 {
-    // Move the terminal's cursor to where the snake's head is
-    printf(MOVE_CURSOR(%zu,%zu), state->position.row, state->position.col);
-    const SnakeDirection old_dir = state->direction;
+    const GameCoord pos = board_coord(state, state->position);
+    const GameCoord food = board_coord(state, state->food);
 
-    if (old_dir == new_dir) // Snake did not change its direction
-    {
-        if (new_dir == DIR_UP || new_dir == DIR_DOWN)
-        {
-            printf(TEXT_GREEN SNAKE_VERTICAL);
-        }
-        else if (new_dir == DIR_LEFT || new_dir == DIR_RIGHT)
-        {
-            printf(TEXT_GREEN SNAKE_HORIZONTAL);
-        }
-        else printf(TEXT_GREEN "?");
-    }
-    else // Snake turned to another direction
+    // Directions to try, in order of preference:
+    // towards the food, then keep going forward, then any other direction
+    SnakeDirection options[DIR_COUNT + 2];
+    size_t count = 0;
+    if (food.row < pos.row) options[count++] = DIR_UP;
+    else if (food.row > pos.row) options[count++] = DIR_DOWN;
+    if (food.col < pos.col) options[count++] = DIR_LEFT;
+    else if (food.col > pos.col) options[count++] = DIR_RIGHT;
+    options[count++] = state->direction;
+    for (SnakeDirection dir = DIR_UP; dir < DIR_COUNT; dir++) options[count++] = dir;
+
+    for (size_t i = 0; i < count; i++)
     {
-        switch (old_dir)
-        {
-            case DIR_UP:
-                if (new_dir == DIR_LEFT)
-                {
-                    printf(TEXT_GREEN SNAKE_TOP_RIGHT);
-                }
-                else if (new_dir ==  DIR_RIGHT)
-                {
-                    printf(TEXT_GREEN SNAKE_TOP_LEFT);
-                }
-                else printf(TEXT_GREEN "?");
-                break;
-            
-            case DIR_DOWN:
-                if (new_dir == DIR_LEFT)
-                {
-                    printf(TEXT_GREEN SNAKE_BOTTOM_RIGHT);
-                }
-                else if (new_dir == DIR_RIGHT)
-                {
-                    printf(TEXT_GREEN SNAKE_BOTTOM_LEFT);
-                }
-                else printf(TEXT_GREEN "?");
-                break;
-            
-            case DIR_LEFT:
-                if (new_dir == DIR_UP)
-                {
-                    printf(TEXT_GREEN SNAKE_BOTTOM_LEFT);
-                }
-                else if (new_dir == DIR_DOWN)
-                {
-                    printf(TEXT_GREEN SNAKE_TOP_LEFT);
-                }
-                else printf(TEXT_GREEN "?");
-                break;
-            
-            case DIR_RIGHT:
-                if (new_dir == DIR_UP)
-                {
-                    printf(TEXT_GREEN SNAKE_BOTTOM_RIGHT);
-                }
-                else if (new_dir == DIR_DOWN)
-                {
-                    printf(TEXT_GREEN SNAKE_TOP_RIGHT);
-                }
-                else printf(TEXT_GREEN "?");
-                break;
-            
-            default:
-                printf(TEXT_GREEN "?");
-                break;
-        }
+        // The snake cannot go backwards
+        SnakeDirection dir = options[i];
+        correct_direction(state, &dir);
+        if (dir != options[i]) continue;
+
+        const GameCell next = state->position + state->dir_step[dir];
+        if (!grid_get(&state->arena, next)) return dir;
     }
 
+    return state->direction;    // There is no way out
+}
+
+// Bend the snake's body to the direction it is turning to.
+// (this function draws the appropriate shape on the point the snake bent)
+void snake_turning(GameState* state, SnakeDirection new_dir)
+{
+    // Draw the body part where the snake's head currently is
+    render_cell(state->render, board_coord(state, state->position), snake_body_cells[state->direction][new_dir]);
+
     // Store the new direction
     state->direction = new_dir;
 }
 
 // Draw the snake's head according to its direction and position
+// (draw in red in case of collision)
 void draw_snake_head(GameState* state, bool has_collided)
 {
-    printf(MOVE_CURSOR(%zu,%zu), state->position.row, state->position.col);
+    render_cell(state->render, board_coord(state, state->position), snake_head_cells[has_collided][state->direction]);
+}
 
-    // The head's color is red in case of collision, green otherwise
-    if (has_collided)
+// Direction of a step from a space to an adjacent one
+static inline SnakeDirection step_direction(const GameState *state, GameCell from, GameCell to)
+{
+    for (SnakeDirection dir = DIR_UP; dir < DIR_COUNT; dir++)
     {
-        printf(TEXT_RED);
+        if ((GameCell)(from + state->dir_step[dir]) == to) return dir;
     }
-    else
+    return DIR_NONE;
+}
+
+// Draw the whole snake, the food pellet, and the snake's size from the current game state
+// (this is for when the screen was erased, like after the terminal was resized)
+// The shape of each body part is worked out from the positions of the parts next to it.
+void draw_game(GameState *state)
+{
+    size_t sid = state->head;
+    draw_snake_head(state, false);
+
+    for (size_t i = 1; i < state->size; i++)
     {
-        printf(TEXT_GREEN);
+        const GameCell newer = state->snake[sid];
+        sid = snake_next(state, sid);
+        const GameCell part = state->snake[sid];
+        const size_t older_id = snake_next(state, sid);
+
+        // The tail is drawn as if the part behind it was in a straight line
+        const SnakeDirection new_dir = step_direction(state, part, newer);
+        const SnakeDirection old_dir = (i < state->size - 1) ? step_direction(state, state->snake[older_id], part) : new_dir;
+        render_cell(state->render, board_coord(state, part), snake_body_cells[old_dir][new_dir]);
     }
-    
-    switch (state->direction)
+
+    if (state->free_area > 0) render_cell(state->render, board_coord(state, state->food), CELL(FOOD_PELLET, CELL_YELLOW));
+    print_snake_size(state);
+}
+
+// Erase the snake, the food pellet, and the snake's size
+// (this is for when the board is going to be set-up again, like when a board of the attract mode starts over)
+void erase_game(GameState *state)
+{
+    const ScreenCell blank = CELL_INIT(" ", CELL_GRAY);
+    for (size_t i = 0, sid = state->head; i < state->size; i++)
     {
-        case DIR_RIGHT:
-            printf(SNAKE_HEAD_RIGHT);
-            break;
-        
-        case DIR_LEFT:
-            printf(SNAKE_HEAD_LEFT);
-            break;
-        
-        case DIR_DOWN:
-            printf(SNAKE_HEAD_DOWN);
-            break;
-        
-        case DIR_UP:
-            printf(SNAKE_HEAD_UP);
-            break;
-        
-        default:
-            printf("?");
-            break;
+        render_cell(state->render, board_coord(state, state->snake[sid]), blank);
+        sid = snake_next(state, sid);
     }
+
+    if (state->free_area > 0) render_cell(state->render, board_coord(state, state->food), blank);
+
+    // Write blank spaces over the digits of the size
+    char size_text[24] = {0};
+    const int digits = snprintf(size_text, sizeof(size_text), "%zu", state->size);
+    memset(size_text, ' ', digits);
+    render_text(state->render, state->size_pos, size_text, CELL_GRAY);
 }
 
 // Display at the bottom of the screen the current snake's size
-void print_snake_size(GameState *state)
+// Returns the screen coordinate right after the size value.
+GameCoord print_snake_size(GameState *state)
 {
-    printf(
-        MOVE_CURSOR(%zu,%d) TEXT_GRAY "Size: " TEXT_WHITE "%zu",
-        state->screen_size.row, SCREEN_MARGIN + 1, state->size
-    );
+    char size_text[24] = {0};
+    snprintf(size_text, sizeof(size_text), "%zu", state->size);
+
+    // The label before the size is part of the static layer, so only the number is written here
+    return render_text(state->render, state->size_pos, size_text, CELL_WHITE);
 }
 
 // Print the game over message
 void game_over(GameState *state)
 {
-    print_snake_size(state); // Has the side effect of moving the cursor to after the size value
+    GameCoord pos = print_snake_size(state);
             
     if (state->free_area == 0)
     {
-        printf(TEXT_YELLOW "  CONGRATULATIONS!");
+        pos = render_text(state->render, pos, "  CONGRATULATIONS!", CELL_YELLOW);
     }
-    else printf(TEXT_RED "  GAME OVER!");
+    else pos = render_text(state->render, pos, "  GAME OVER!", CELL_RED);
     
-    printf(TEXT_CYAN "  Press any key to exit...\a"); // '\a' makes a notification sound on the terminal
-    fflush(stdout);
+    render_text(state->render, pos, "  Press any key to exit...", CELL_CYAN);
+    render_bell(state->render);    // Makes a notification sound on the terminal
+    render_submit(state->render, state->backend, true);
 
     // Wait a little without taking input so the user does not accidentally exit at the end
     wait_usec(750000);  // 0.75 seconds
     flush_stdin();
+
+    #ifndef _WIN32
+    // The signals are blocked on Linux, so they are read while waiting (a SIGTERM still closes the program)
+    while (!input_available())
+    {
+        wait_input();
+        terminal_resized();
+    }
+    #endif // _WIN32
+
     #ifdef _MSC_VER
     #pragma warning(push)
     #pragma warning(disable: 6031)  // Disable the "unused return value" warning on the MSVC compiler's analyzer
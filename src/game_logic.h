@@ -2,10 +2,26 @@
 
 #include "includes.h"
 
+// Body part drawn where the snake's head was, indexed by [old direction][new direction]
+extern const ScreenCell snake_body_cells[DIR_COUNT][DIR_COUNT];
+
+// Snake's head, indexed by [has collided][direction]
+extern const ScreenCell snake_head_cells[2][DIR_COUNT];
+
+// Space of the board at the given coordinate
+inline GameCell board_cell(const GameState *state, GameCoord pos);
+
+// Coordinate of a space of the board (this is for drawing it)
+inline GameCoord board_coord(const GameState *state, GameCell cell);
+
+// Index of the snake's queue where the part after the given one is (going from the head towards the tail)
+inline size_t snake_next(const GameState *state, size_t sid);
+
 // Spawn a food pellet at a random empty space
 void spawn_food(GameState *state);
 
 // Get which direction the user has pressed
+// The input that is available is read all at once, then decoded (see input_buffer.h). This never waits for more input.
 SnakeDirection parse_input(GameState* state);
 
 // Move the snake by one unit in a given direction
@@ -16,6 +32,10 @@ bool move_snake(GameState* state, SnakeDirection dir);
 // This function flips the new direction in case it's going to the opposite direction of the snake.
 inline void correct_direction(GameState* state, SnakeDirection* new_dir);
 
+// Pick a direction that moves the snake towards the food pellet, while avoiding a collision on the next move
+// (this is for moving the snake without a player)
+SnakeDirection autopilot(GameState *state);
+
 // Bend the snake's body to the direction it is turning to.
 // (this function draws the appropriate shape on the point the snake bent)
 void snake_turning(GameState* state, SnakeDirection new_dir);
@@ -24,8 +44,18 @@ void snake_turning(GameState* state, SnakeDirection new_dir);
 // (draw in red in case of collision)
 void draw_snake_head(GameState* state, bool has_collided);
 
+// Draw the whole snake, the food pellet, and the snake's size from the current game state
+// (this is for when the screen was erased, like after the terminal was resized)
+// The shape of each body part is worked out from the positions of the parts next to it.
+void draw_game(GameState *state);
+
+// Erase the snake, the food pellet, and the snake's size
+// (this is for when the board is going to be set-up again, like when a board of the attract mode starts over)
+void erase_game(GameState *state);
+
 // Display at the bottom of the screen the current snake's size
-void print_snake_size(GameState *state);
+// Returns the screen coordinate right after the size value.
+GameCoord print_snake_size(GameState *state);
 
 // Print the game over message
 void game_over(GameState *state);
@@ -1,10 +1,10 @@
 #include "includes.h"
 
 // Set-up the game state and draw the initial screen
-// 'speed' is a value from 1 to 12 for setting the initial snake's speed.
+// 'options->speed' is a value from 1 to 12 for setting the initial snake's speed.
 // 5 is the default speed. 1 is half of the default and 9 is double of the default.
 // Other values are a linear interpolation between those points.
-GameState* game_init(unsigned int speed)
+GameState* game_init(const GameOptions *options)
 {
     // Reset the terminal to its default properties when the program exits
     atexit(&cleanup);         // Run our clean-up routine on exit
@@ -16,58 +16,54 @@ GameState* game_init(unsigned int speed)
     signal(SIGSEGV, &exit_segfault);    // Closing due to a segmentation fault (this should never happen)
 
     // Allocate and initialize the game state
-    GameState *state = xmalloc(sizeof(GameState));
+    GameState *state = xmalloc_aligned(sizeof(GameState));
+    state->term = xmalloc(sizeof(TermState));
+    state->options = *options;
+    state->origin = (GameCoord){1, 1};
+    state->has_focus = true;
+    state->start_time = clock_usec();
     state_ptr = state;
 
     #ifdef _WIN32
 
     // Make the terminal to accept Unicode characters encoded in UTF-8
-    state->output_cp_old = GetConsoleOutputCP();
+    state->term->output_cp_old = GetConsoleOutputCP();
     WINDOWS_ERROR_CHECK(SetConsoleOutputCP(CP_UTF8));
 
     // Get the Windows' handles for the standard input and output streams
-    state->output_handle = GetStdHandle(STD_OUTPUT_HANDLE);
-    state->input_handle = GetStdHandle(STD_INPUT_HANDLE);
+    state->term->output_handle = GetStdHandle(STD_OUTPUT_HANDLE);
+    state->term->input_handle = GetStdHandle(STD_INPUT_HANDLE);
 
     // Get the settings of the output stream
-    WINDOWS_ERROR_CHECK(GetConsoleMode(state->output_handle, &state->output_mode));
-    state->output_mode_old = state->output_mode;
+    WINDOWS_ERROR_CHECK(GetConsoleMode(state->term->output_handle, &state->term->output_mode));
+    state->term->output_mode_old = state->term->output_mode;
 
     // Get the settings of the input stream
-    WINDOWS_ERROR_CHECK(GetConsoleMode(state->input_handle, &state->input_mode));
-    state->input_mode_old = state->input_mode;
+    WINDOWS_ERROR_CHECK(GetConsoleMode(state->term->input_handle, &state->term->input_mode));
+    state->term->input_mode_old = state->term->input_mode;
 
     // Get the style of the window where the terminal is
-    state->window = GetConsoleWindow();
-    WINDOWS_ERROR_CHECK( state->window_mode = GetWindowLong(state->window, GWL_STYLE) );
-    state->window_mode_old = state->window_mode;
+    state->term->window = GetConsoleWindow();
+    WINDOWS_ERROR_CHECK( state->term->window_mode = GetWindowLong(state->term->window, GWL_STYLE) );
+    state->term->window_mode_old = state->term->window_mode;
 
     // Enable escape sequences on the terminal,
     // and do not move to the next line when writing a character to the end of a line
-    state->output_mode |= (ENABLE_VIRTUAL_TERMINAL_PROCESSING | DISABLE_NEWLINE_AUTO_RETURN);
-    WINDOWS_ERROR_CHECK(SetConsoleMode(state->output_handle, state->output_mode));
+    state->term->output_mode |= (ENABLE_VIRTUAL_TERMINAL_PROCESSING | DISABLE_NEWLINE_AUTO_RETURN);
+    WINDOWS_ERROR_CHECK(SetConsoleMode(state->term->output_handle, state->term->output_mode));
     windows_vt_seq = true;
 
     // Enable input through the arrows on the terminal.
     // Also make so new characters overwrite existing ones,
     // the input is sent immediately after a key is pressed,
     // and ignore mouse input.
-    state->input_mode |= ENABLE_VIRTUAL_TERMINAL_INPUT;
-    state->input_mode &= (~ENABLE_INSERT_MODE & ~ENABLE_LINE_INPUT & ~ENABLE_ECHO_INPUT & ~ENABLE_MOUSE_INPUT &~ENABLE_WINDOW_INPUT);
-    WINDOWS_ERROR_CHECK(SetConsoleMode(state->input_handle, state->input_mode));
+    state->term->input_mode |= ENABLE_VIRTUAL_TERMINAL_INPUT;
+    state->term->input_mode &= (~ENABLE_INSERT_MODE & ~ENABLE_LINE_INPUT & ~ENABLE_ECHO_INPUT & ~ENABLE_MOUSE_INPUT &~ENABLE_WINDOW_INPUT);
+    WINDOWS_ERROR_CHECK(SetConsoleMode(state->term->input_handle, state->term->input_mode));
     
     // For the terminal's window, disable: maximizing button, resizing, horizontal and vertical scrollbars
-    state->window_mode &= (~WS_MAXIMIZEBOX & ~WS_SIZEBOX & ~WS_HSCROLL & ~WS_VSCROLL);
-    WINDOWS_ERROR_CHECK(SetWindowLong(state->window, GWL_STYLE, state->window_mode));
-
-    // Get the amount of rows and columns that are visible on the terminal window
-    CONSOLE_SCREEN_BUFFER_INFO buffer_info = {0};
-    WINDOWS_ERROR_CHECK(GetConsoleScreenBufferInfo(state->output_handle, &buffer_info));
-    
-    state->screen_size = (GameCoord){
-        buffer_info.srWindow.Bottom - buffer_info.srWindow.Top + 1,
-        buffer_info.srWindow.Right - buffer_info.srWindow.Left + 1,
-    };
+    state->term->window_mode &= (~WS_MAXIMIZEBOX & ~WS_SIZEBOX & ~WS_HSCROLL & ~WS_VSCROLL);
+    WINDOWS_ERROR_CHECK(SetWindowLong(state->term->window, GWL_STYLE, state->term->window_mode));
 
     #else // Linux
 
@@ -75,24 +71,32 @@ GameState* game_init(unsigned int speed)
     // (that is, no need for a line to be entered in order for us to read the user's input)
     struct termios term_flags = {0};
     LINUX_ERROR_CHECK(tcgetattr(STDIN_FILENO, &term_flags));
-    state->term_flags_old = term_flags;
+    state->term->term_flags_old = term_flags;
     term_flags.c_lflag &= (~ECHO & ~ICANON);
     LINUX_ERROR_CHECK(tcsetattr(STDIN_FILENO, TCSANOW, &term_flags));
     linux_term_flags_set = true;
 
-    // Get the amount of rows and columns that are visible on the terminal window
-    struct winsize term_size = {0};
-    LINUX_ERROR_CHECK(ioctl(STDOUT_FILENO, TIOCGWINSZ, &term_size));
-    state->screen_size = (GameCoord){
-        term_size.ws_row,
-        term_size.ws_col,
-    };
-
-    // Change the terminal back to the original size when the window is resized
-    signal(SIGWINCH, &restore_term);
+    // The main loop waits at once for the input, the timer of the next tick, and the signals (see wait_event())
+    // The signals for when the window is resized and for closing are blocked, so they only arrive through a descriptor.
+    if (signal_fd < 0)
+    {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGWINCH);
+        sigaddset(&signals, SIGTERM);
+        LINUX_ERROR_CHECK(sigprocmask(SIG_BLOCK, &signals, NULL));
+        LINUX_ERROR_CHECK(signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC));
+        LINUX_ERROR_CHECK(timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC));
+    }
 
     #endif // _WIN_32
 
+    // Get the amount of rows and columns that are visible on the terminal window
+    const GameCoord term_size = terminal_size(state);
+
+    // The board takes the whole terminal, unless its cells are packed (then the board has more cells than the terminal)
+    state->screen_size = packed_board_size(options->pack_mode, term_size.row, term_size.col);
+
     // Map the directions to the "WASD" equivalent keys of the current keyboard layout
     state->keymap = map_scancodes(SCANCODE_UP, SCANCODE_LEFT, SCANCODE_DOWN, SCANCODE_RIGHT);
     if (!state->keymap)
@@ -100,6 +104,9 @@ GameState* game_init(unsigned int speed)
         printf_error_exit(ERR_KEYMAP_FAIL, "Failed to map the keyboard keys.");
     }
 
+    // The input is read into this buffer, then decoded from it
+    state->input = input_create();
+
     // Distance from the borders of the window in which the snake may not spawn
     const size_t safety_distance = SCREEN_MARGIN + SNAKE_START_SIZE + 1;
     const size_t size_cutoff = 2 * safety_distance;
@@ -107,14 +114,95 @@ GameState* game_init(unsigned int speed)
     // Check if the terminal is big enough for the game
     if ( (state->screen_size.row <= size_cutoff) || (state->screen_size.col <= size_cutoff) )
     {
+        // On the packed modes, each character holds more than one cell of the board (and the last row is left for the text)
+        GameCoord min_size = {size_cutoff + 1, size_cutoff + 1};
+        if (options->pack_mode != PACK_NONE) min_size.row = (min_size.row + 1) / 2 + 1;
+        if (options->pack_mode == PACK_QUAD) min_size.col = (min_size.col + 1) / 2;
+
         printf_error_exit(
             ERR_TINY_TERMINAL,
             "Terminal's size is too small for the game, "
             "it should be at least %zu by %zu characters.",
-            size_cutoff+1, size_cutoff+1
+            min_size.row, min_size.col
         );
     }
 
+    // Switch to the alternate terminal screen.
+    // Then make its background black, its text light grey, enable keyboard input, and hide the cursor.
+    printf(ALT_SCREEN BG_BLACK TEXT_GRAY CLEAR_SCREEN KP_APP_MODE CK_APP_MODE HIDE_CURSOR);
+
+    // Change the window's title to "Snake Game"
+    printf(SET_WINDOW_TITLE("Snake Game"));
+
+    // The game's frames are written directly to the terminal, without going through stdout.
+    // So the sequences above need to be output before the first frame.
+    fflush(stdout);
+
+    // Set the input stream to unbuffered so keyboard input can be parsed faster and be cleared more easily
+    // Notes: We are going to parse input once per frame. Once we successfully parse a key, we clear the remaining data on stdin.
+    //        If stdin was buffered some data could still be on the buffer, which wouldn't be cleared after flushing stdin.
+    setvbuf(stdin, NULL, _IONBF, 0);
+
+    // Characters on the terminal screen
+    // (the game is drawn to this buffer, which is then flushed to the terminal at the end of each frame)
+    state->screen = screen_create(term_size.row, term_size.col);
+
+    // Let the terminal to display each frame at once, if it supports doing so
+    state->screen->sync_output = terminal_has_sync_output();
+
+    // Let the terminal to repeat characters by itself when drawing long lines, if it supports doing so
+    state->screen->has_rep = terminal_has_rep();
+
+    // Draw the lines with single byte characters if that was requested, or if the terminal does not understand UTF-8
+    state->screen->dec_graphics = options->dec_graphics || !terminal_has_utf8();
+
+    // Let the terminal to report when its window gains or loses focus, so the game can pause while it is in the background
+    // (this is only enabled after the queries above, so the reports do not get mixed with their replies)
+    printf(FOCUS_REPORT_ON);
+    fflush(stdout);
+
+    // Pack the board cells into the terminal cells, if that was requested
+    // (the attract mode does not pack its boards)
+    if (options->pack_mode != PACK_NONE && options->demo_boards == 0)
+    {
+        state->packed = packed_create(state->screen, options->pack_mode);
+    }
+
+    // Draw commands of each tick, which are drawn to the terminal screen
+    state->render = xmalloc(sizeof(RenderList));
+    render_init(state->render);
+    state->backend = xmalloc(sizeof(RenderBackend));
+    *state->backend = state->packed ? render_backend_packed(state->packed) : render_backend_screen(state->screen);
+
+    // On the attract mode, the screen is divided among several boards that are played by the autopilot
+    if (options->demo_boards > 0)
+    {
+        demo_init(state);
+        return state;
+    }
+
+    // Draw a rectangle along the terminal's borders, and the label of the snake's size below it
+    draw_board_frame(state);
+
+    // Spawn the snake and the food pellet
+    board_init(state);
+
+    // Output the game screen to the terminal
+    // (the static layer is drawn first, then the snake and the food over it)
+    screen_redraw(state->screen);
+    render_submit(state->render, state->backend, true);
+
+    return state;
+}
+
+// Draw a rectangle along the board's borders, and the label of the snake's size below it
+// They are part of the static layer of the screen, which is pre-rendered once then reused on every redraw.
+void draw_board_frame(GameState *state)
+{
+    // Distance from the terminal's top left corner to the region where the game is
+    // (the static layer is on terminal coordinates, while the game draws on coordinates relative to its region)
+    const GameCoord offset = {state->origin.row - 1, state->origin.col - 1};
+
     // Top left coordinates of the board
     const GameCoord board_start = {
         SCREEN_MARGIN + 1,
@@ -127,66 +215,110 @@ GameState* game_init(unsigned int speed)
         state->screen_size.col - SCREEN_MARGIN,
     };
 
-    // Switch to the alternate terminal screen.
-    // Then make its background black, its text light grey, enable keyboard input, and hide the cursor.
-    printf(ALT_SCREEN BG_BLACK TEXT_GRAY CLEAR_SCREEN KP_APP_MODE CK_APP_MODE HIDE_CURSOR);
-
-    // Change the window's title to "Snake Game"
-    printf(SET_WINDOW_TITLE("Snake Game"));
-
-    // Set the output stream to fully buffered so it is only drawn when we flush it
-    setvbuf(stdout, NULL, _IOFBF, state->screen_size.col * state->screen_size.row * 4);
+    // When the board cells are packed, the label goes on the terminal's last row (which is not part of the board)
+    // Note: the packed boards always take the whole terminal.
+    GameCoord label_pos = {state->screen_size.row + offset.row, SCREEN_MARGIN + 1 + offset.col};
+    if (state->packed)
+    {
+        packed_static_box(state->packed, board_start, board_end, CELL_GRAY);
+        label_pos.row = state->screen->rows;
+    }
+    else
+    {
+        screen_static_box(
+            state->screen,
+            (GameCoord){board_start.row + offset.row, board_start.col + offset.col},
+            (GameCoord){board_end.row + offset.row, board_end.col + offset.col},
+            CELL_GRAY
+        );
+    }
 
-    // Set the input stream to unbuffered so keyboard input can be parsed faster and be cleared more easily
-    // Notes: We are going to parse input once per frame. Once we successfully parse a key, we clear the remaining data on stdin.
-    //        If stdin was buffered some data could still be on the buffer, which wouldn't be cleared after flushing stdin.
-    setvbuf(stdin, NULL, _IONBF, 0);
+    // The snake's size is displayed right after the label
+    state->size_pos = screen_static_text(state->screen, label_pos, HUD_SIZE_LABEL, CELL_GRAY);
+    state->size_pos.col -= offset.col;
+    if (!state->packed) state->size_pos.row -= offset.row;
+}
 
-    // 2D array for the collision grid
-    // ('true' means a position where the snake collides with an wall or itself)
-    state->arena = (bool**)alloc_2Darray(
-        state->screen_size.col,
-        state->screen_size.row,
-        sizeof(typeof(**state->arena))
-    );
+// Adapt the game to the current size of the terminal window, after it was resized
+// The board is resized (see board_resize()), then the screen is erased and drawn again from the game state.
+void game_resize(GameState *state)
+{
+    ScreenBuffer *screen = state->screen;
+    const GameCoord size = terminal_size(state);
+    if (size.row == 0 || size.col == 0) return;
+    if (size.row == screen->rows && size.col == screen->cols) return;
 
-    /* Drawing a rectangle along the terminal's borders */
-    
-    // Draw the top border
-    printf(MOVE_CURSOR(%zu, %zu) BOX_TOP_LEFT, board_start.row, board_start.col);
-    state->arena[board_start.row - 1][board_start.col - 1] = true;
-    
-    const size_t top_count = state->screen_size.col - 2 * (SCREEN_MARGIN + 1);
-    for (size_t i = 0; i < top_count; i++)
+    // On the attract mode, the boards start over on the resized screen
+    if (state->demo)
     {
-        printf(BOX_HORIZONTAL);
-        state->arena[board_start.row - 1][board_start.col + i] = true;
+        screen_resize(screen, size.row, size.col);
+        if (!demo_layout(state, state->options.demo_boards)) screen_flush(screen, true);
+        return;
     }
 
-    printf(BOX_TOP_RIGHT);
-    state->arena[board_start.row - 1][board_start.col + top_count] = true;
-    
-    // Draw the laterals
-    for (size_t i = board_start.row + SCREEN_MARGIN; i <= board_end.row; i++)
+    board_resize(state, packed_board_size(state->options.pack_mode, size.row, size.col));
+    screen_resize(screen, size.row, size.col);
+    if (state->packed) packed_resize(state->packed);
+
+    // Draw everything again, all at once
+    // (the commands of the ticks that were not drawn while catching up are on the coordinates from before the resize,
+    // so they are discarded: the whole game is drawn again anyway)
+    render_clear(state->render);
+    draw_board_frame(state);
+    draw_game(state);
+    screen_redraw(screen);
+    render_submit(state->render, state->backend, true);
+}
+
+// Pause the game while the terminal's window does not have focus, without drawing anything
+// The game resumes when the window gets focus again, or when a direction key is pressed.
+// Then the screen is redrawn from what is retained on the screen buffer.
+void game_suspend(GameState *state)
+{
+    while (!state->has_focus)
     {
-        printf(MOVE_CURSOR(%zu, %zu) BOX_VERTICAL MOVE_CURSOR(%zu, %zu) BOX_VERTICAL, i, board_start.col, i, board_end.col);
-        state->arena[i - 1][board_start.col - 1] = true;
-        state->arena[i - 1][board_end.col - 1] = true;
+        // Sleep until the terminal sends something
+        wait_input();
+        if (terminal_resized()) game_resize(state);
+        if (parse_input(state) != DIR_NONE) state->has_focus = true;
     }
 
-    // Draw the bottom border
-    printf(MOVE_CURSOR(%zu, %zu) BOX_BOTTOM_LEFT, board_end.row, board_start.col);
-    state->arena[board_end.row - 1][board_start.col - 1] = true;
+    // The terminal might have lost some of its contents while in the background, so everything is drawn again
+    screen_redraw(state->screen);
+    render_submit(state->render, state->backend, true);
+}
 
-    const size_t bottom_count = state->screen_size.col - 2 * (SCREEN_MARGIN + 1);
-    for (size_t i = 0; i < bottom_count; i++)
+// Pause the game until the ESC key or a direction key is pressed (the game is paused with the ESC key)
+// The timer of the ticks is disarmed, so the process sleeps until the input arrives.
+// The game is drawn normally while paused (such as after the terminal was resized).
+void game_pause(GameState *state)
+{
+    while (!input_escape(state->input))
     {
-        printf(BOX_HORIZONTAL);
-        state->arena[board_end.row - 1][board_start.col + i] = true;
+        // The timer is only armed to tell apart an ESC from the start of a sequence
+        arm_timer(input_escape_deadline(state->input));
+
+        const unsigned int events = wait_event(true);
+        if ((events & EVENT_SIGNAL) && terminal_resized()) game_resize(state);
+        if ((events & EVENT_INPUT) && parse_input(state) != DIR_NONE) break;
     }
-    
-    printf(BOX_BOTTOM_RIGHT);
-    state->arena[board_end.row - 1][board_start.col + bottom_count] = true;
+}
+
+// Set-up the collision grid, the snake, the food pellet, and the snake's speed
+// The fields .screen_size, .size_pos, .options, and .render of the state must already be set,
+// and the screen must be big enough for the game. The snake and the food are drawn to .render.
+void board_init(GameState *state)
+{
+    // Distance from the borders of the window in which the snake may not spawn
+    const size_t safety_distance = SCREEN_MARGIN + SNAKE_START_SIZE + 1;
+
+    // Collision grid
+    // (a set bit means a position where the snake collides with an wall or itself)
+    grid_init(&state->arena, state->screen_size.row, state->screen_size.col);
+    board_steps(state);
+
+    // Flag the borders as walls on the collision grid
+    board_walls(state);
 
     /* Snake spawning */
 
@@ -209,8 +341,14 @@ GameState* game_init(unsigned int speed)
     state->total_area = box_size.row * box_size.col;
     state->free_area = state->total_area - SNAKE_START_SIZE;
 
-    // Double-ended queue for storing the coordinates of where each snake part is
-    state->snake = xmalloc(sizeof(typeof(*state->snake)) * state->total_area);
+    // List of the empty spaces on the snake's area
+    // (the snake's parts are removed from it as they are drawn)
+    board_spaces(state);
+
+    // Double-ended queue for storing where each snake part is
+    // (it starts small, and grows as the snake does)
+    state->snake_capacity = SNAKE_START_CAPACITY;
+    state->snake = xmalloc(sizeof(typeof(*state->snake)) * state->snake_capacity);
     size_t sid = 0; // Current index on 'state->snake[]'
 
     // Region in which the snake may spawn
@@ -232,22 +370,20 @@ GameState* game_init(unsigned int speed)
     // Note: xrand() already seeds itself using the operating system's entropy source
     const size_t row_delta = xrand() % region_size.row;
     const size_t col_delta = xrand() % region_size.col;
-    state->position = (GameCoord){
+    const GameCoord start = {
         .row = region_min.row + row_delta,
         .col = region_min.col + col_delta,
     };
+    state->position = board_cell(state, start);
 
     // Randomize the snakes direction
     const bool is_horizontal = xrand() % 2;
     
     // The snake will spawn facing away from the closest wall in its direction
     const GameCoord mid_point = {state->position_max.row / 2, state->position_max.col / 2,};
-    const char* snake_body = NULL;
     if (is_horizontal)
     {
-        snake_body = SNAKE_HORIZONTAL;
-
-        if (state->position.col < mid_point.col)
+        if (start.col < mid_point.col)
         {
             state->direction = DIR_RIGHT;
         }
@@ -258,9 +394,7 @@ GameState* game_init(unsigned int speed)
     }
     else // vertical
     {
-        snake_body = SNAKE_VERTICAL;
-        
-        if (state->position.row < mid_point.row)
+        if (start.row < mid_point.row)
         {
             state->direction = DIR_DOWN;
         }
@@ -270,48 +404,26 @@ GameState* game_init(unsigned int speed)
         }
     }
 
-    // The starting head's direction
-    const char* snake_head = "?";
-    switch (state->direction)
-    {
-        case DIR_RIGHT:
-            snake_head = SNAKE_HEAD_RIGHT;
-            break;
-        
-        case DIR_LEFT:
-            snake_head = SNAKE_HEAD_LEFT;
-            break;
-        
-        case DIR_DOWN:
-            snake_head = SNAKE_HEAD_DOWN;
-            break;
-        
-        case DIR_UP:
-            snake_head = SNAKE_HEAD_UP;
-            break;
-        
-        default:
-            break;
-    }
-
     /* Draw the snake */
 
-    GameCoord pos = {state->position.row, state->position.col}; // Current drawing position
+    GameCell pos = state->position;  // Current drawing position
 
     // Draw the head at the starting position
     // (the snake's color is green)
-    printf(MOVE_CURSOR(%zu,%zu) TEXT_GREEN "%s", pos.row, pos.col, snake_head);
-    state->arena[pos.row - 1][pos.col - 1] = true;
+    render_cell(state->render, board_coord(state, pos), snake_head_cells[false][state->direction]);
+    grid_set(&state->arena, pos);
+    spaces_occupy(state->free_spaces, pos);
     state->head = sid;
-    state->snake[sid++] = (GameCoord){pos.row, pos.col};
+    state->snake[sid++] = pos;
 
     // Draw the body
     for (size_t i = 0; i < (SNAKE_START_SIZE - 1); i++)
     {
-        move_coord(&pos, state->direction, -1);
-        printf(MOVE_CURSOR(%zu,%zu) "%s", pos.row, pos.col, snake_body);
-        state->arena[pos.row - 1][pos.col - 1] = true;
-        state->snake[sid++] = (GameCoord){pos.row, pos.col};
+        pos -= state->dir_step[state->direction];
+        render_cell(state->render, board_coord(state, pos), snake_body_cells[state->direction][state->direction]);
+        grid_set(&state->arena, pos);
+        spaces_occupy(state->free_spaces, pos);
+        state->snake[sid++] = pos;
     }
     state->tail = sid - 1;
 
@@ -330,6 +442,7 @@ GameState* game_init(unsigned int speed)
     state->tick_time_final = 1000000 / SNAKE_FINAL_SPEED;
 
     // Clamp the game speed to the range [1, 12]
+    unsigned int speed = state->options.speed;
     if (speed < 1) speed = 1;
     if (speed > 12) speed = 12;
 
@@ -352,17 +465,271 @@ GameState* game_init(unsigned int speed)
         state->tick_time_final -= (delta_f * (speed - 5)) / 4;
     }
     
-    // Output the game screen to the terminal
-    fflush(stdout);
+}
 
-    return state;
+// Flag the borders of the board as walls on the collision grid
+// The board takes the whole .screen_size of the state, except for the margin around it.
+void board_walls(GameState *state)
+{
+    // Top left coordinates of the board
+    const GameCoord board_start = {
+        SCREEN_MARGIN + 1,
+        SCREEN_MARGIN + 1,
+    };
+
+    // Bottom right coordinates of the board
+    const GameCoord board_end = {
+        state->screen_size.row - SCREEN_MARGIN,
+        state->screen_size.col - SCREEN_MARGIN,
+    };
+
+    // Top and bottom walls
+    const GameCell top_left = board_cell(state, board_start);
+    const GameCell bottom_right = board_cell(state, board_end);
+    const size_t width = board_end.col - board_start.col;
+    grid_set_run(&state->arena, top_left, top_left + width);
+    grid_set_run(&state->arena, bottom_right - width, bottom_right);
+
+    // Left and right walls
+    for (GameCell cell = top_left; cell <= bottom_right; cell += state->arena.stride)
+    {
+        grid_set(&state->arena, cell);
+        grid_set(&state->arena, cell + width);
+    }
+}
+
+// Set the offset of the space when moving in each direction, from the stride of the collision grid
+void board_steps(GameState *state)
+{
+    const int32_t stride = (int32_t)state->arena.stride;
+    state->dir_step[DIR_NONE] = 0;
+    state->dir_step[DIR_UP] = -stride;
+    state->dir_step[DIR_DOWN] = stride;
+    state->dir_step[DIR_RIGHT] = 1;
+    state->dir_step[DIR_LEFT] = -1;
+}
+
+// Create the list of empty spaces, with all spaces of the snake's area on it
+// The fields .position_min and .position_max of the state must already be set.
+void board_spaces(GameState *state)
+{
+    state->free_spaces = spaces_create(state->arena.rows * state->arena.stride);
+    const size_t width = state->position_max.col - state->position_min.col;
+
+    for (size_t row = state->position_min.row; row <= state->position_max.row; row++)
+    {
+        const GameCell first = board_cell(state, (GameCoord){row, state->position_min.col});
+        for (GameCell cell = first; cell <= first + width; cell++)
+        {
+            spaces_release(state->free_spaces, cell);
+        }
+    }
+}
+
+// Count the empty spaces of the snake's area on the collision grid, one row at a time (see grid_count_free())
+size_t board_free_area(const GameState *state)
+{
+    const size_t width = state->position_max.col - state->position_min.col;
+    size_t count = 0;
+
+    for (size_t row = state->position_min.row; row <= state->position_max.row; row++)
+    {
+        const GameCell first = board_cell(state, (GameCoord){row, state->position_min.col});
+        count += grid_count_free(&state->arena, first, first + width);
+    }
+
+    return count;
+}
+
+// Change the size of the board to fit a new screen size, keeping the snake and the food pellet on it
+// The collision grid and the snake's queue are reallocated to the new size, and the snake is copied over.
+// When the board shrinks, the snake and the food are moved up and to the left as much as needed for them to fit.
+// The board does not shrink past the snake's extent or below the minimum size for the game,
+// so in those cases it extends beyond the new screen size (and the part outside of the screen is not displayed).
+// If the food pellet ends up outside of the board, it is spawned again. Nothing else is drawn.
+void board_resize(GameState *state, GameCoord screen_size)
+{
+    // Rectangle that contains the whole snake
+    GameCoord snake_min = board_coord(state, state->snake[state->head]);
+    GameCoord snake_max = snake_min;
+    for (size_t i = 0, sid = state->head; i < state->size; i++)
+    {
+        const GameCoord part = board_coord(state, state->snake[sid]);
+        if (part.row < snake_min.row) snake_min.row = part.row;
+        if (part.col < snake_min.col) snake_min.col = part.col;
+        if (part.row > snake_max.row) snake_max.row = part.row;
+        if (part.col > snake_max.col) snake_max.col = part.col;
+        sid = snake_next(state, sid);
+    }
+
+    // Minimum size for the game
+    const size_t size_cutoff = 2 * (SCREEN_MARGIN + SNAKE_START_SIZE + 1);
+    GameCoord new_size = {
+        .row = (screen_size.row > size_cutoff) ? screen_size.row : size_cutoff + 1,
+        .col = (screen_size.col > size_cutoff) ? screen_size.col : size_cutoff + 1,
+    };
+
+    // The snake must remain inside the board
+    // (the spaces beyond the snake's bottom right corner must be at least its extent, minus the spaces before its top left corner)
+    const GameCoord snake_reach = {
+        .row = snake_max.row - snake_min.row + state->position_min.row + SCREEN_MARGIN + 1,
+        .col = snake_max.col - snake_min.col + state->position_min.col + SCREEN_MARGIN + 1,
+    };
+    if (new_size.row < snake_reach.row) new_size.row = snake_reach.row;
+    if (new_size.col < snake_reach.col) new_size.col = snake_reach.col;
+
+    if (new_size.row == state->screen_size.row && new_size.col == state->screen_size.col) return;
+
+    const size_t old_stride = state->arena.stride;
+    state->screen_size = new_size;
+    state->position_max = (GameCoord){
+        .row = state->screen_size.row - (SCREEN_MARGIN + 1),
+        .col = state->screen_size.col - (SCREEN_MARGIN + 1),
+    };
+    state->total_area = (state->position_max.row - state->position_min.row + 1)
+                      * (state->position_max.col - state->position_min.col + 1);
+
+    // How many spaces the snake needs to be moved up and to the left in order to fit on the new board
+    const GameCoord shift = {
+        .row = (snake_max.row > state->position_max.row) ? snake_max.row - state->position_max.row : 0,
+        .col = (snake_max.col > state->position_max.col) ? snake_max.col - state->position_max.col : 0,
+    };
+
+    // Coordinate of the food pellet on the old board (or zero if there is no food pellet)
+    GameCoord food = (state->food != NO_CELL) ? board_coord(state, state->food) : (GameCoord){0, 0};
+
+    // New collision grid and list of empty spaces
+    // (the snake's area only has the snake in it, so its parts are flagged again on both as they are copied)
+    grid_free(&state->arena);
+    grid_init(&state->arena, state->screen_size.row, state->screen_size.col);
+    board_steps(state);
+    board_walls(state);
+    spaces_destroy(state->free_spaces);
+    board_spaces(state);
+
+    // Copy the snake to a new queue, from the head to the tail
+    // (the spaces depend on the stride of the collision grid, so they are worked out again for the new board)
+    GameCell *snake = xmalloc(sizeof(typeof(*state->snake)) * state->snake_capacity);
+    for (size_t i = 0, sid = state->head; i < state->size; i++)
+    {
+        const GameCell old_cell = state->snake[sid];
+        const GameCoord part = {old_cell / old_stride + 1 - shift.row, old_cell % old_stride + 1 - shift.col};
+        const GameCell cell = board_cell(state, part);
+        grid_set(&state->arena, cell);
+        spaces_occupy(state->free_spaces, cell);
+        snake[i] = cell;
+        sid = snake_next(state, sid);
+    }
+
+    free(state->snake);
+    state->snake = snake;
+    state->head = 0;
+    state->tail = state->size - 1;
+    state->position = snake[0];
+    state->free_area = board_free_area(state);
+
+    // The food pellet moves along with the snake, unless that would put it outside of the board
+    if (food.row >= state->position_min.row + shift.row && food.col >= state->position_min.col + shift.col)
+    {
+        food.row -= shift.row;
+        food.col -= shift.col;
+    }
+
+    if (
+        food.row > state->position_max.row || food.col > state->position_max.col ||
+        food.row < state->position_min.row || food.col < state->position_min.col ||
+        grid_get(&state->arena, board_cell(state, food))
+    )
+    {
+        spawn_food(state);
+    }
+    else state->food = board_cell(state, food);
+}
+
+// Free the memory used by the collision grid, the list of empty spaces, and the snake
+void board_free(GameState *state)
+{
+    grid_free(&state->arena);
+    spaces_destroy(state->free_spaces);
+    state->free_spaces = NULL;
+    free(state->snake);
+    state->snake = NULL;
+}
+
+// Move the deadline of the next tick forward by the given duration, then set the timer to it (see arm_timer())
+// The deadlines do not depend on how long each tick took, so the ticks keep the same rate on the long run.
+// When the deadline has already passed, it is counted as missed and the next tick starts right away without being drawn
+// (so the game catches up), unless it is more than CATCH_UP_TICKS behind, in which case the schedule starts over from now.
+// Returns whether the next tick should be drawn.
+bool schedule_next_tick(GameState *state, uint64_t *deadline, uint64_t duration)
+{
+    *deadline += duration;
+    bool draw = true;
+
+    const uint64_t now = clock_usec();
+    if (now > *deadline)
+    {
+        state->deadlines_missed++;
+        if (now - *deadline > duration * CATCH_UP_TICKS)
+        {
+            *deadline = now;
+            state->schedule_resets++;
+        }
+        else draw = false;
+    }
+
+    arm_timer(*deadline);
+    return draw;
+}
+
+// Wait until the timer of the next tick expires, while taking the input as soon as it arrives
+// Returns the first direction key that was pressed (the input that arrives after it is left for the next ticks).
+// If the terminal is resized, the game is adapted to the new size while waiting (then 'true' is stored on 'resized').
+// The wait only ends early if the window lost focus, so the schedule of the ticks is kept.
+SnakeDirection wait_next_tick(GameState *state, bool *resized)
+{
+    SnakeDirection dir = DIR_NONE;
+
+    while (true)
+    {
+        // Once a direction was taken, the input is no longer waited for until the next tick
+        const unsigned int events = wait_event(dir == DIR_NONE);
+
+        if ((events & EVENT_SIGNAL) && terminal_resized())
+        {
+            game_resize(state);
+            *resized = true;
+        }
+
+        if (events & EVENT_INPUT)
+        {
+            dir = parse_input(state);
+            if (!state->has_focus) break;
+        }
+
+        if (events & EVENT_TIMER) break;
+    }
+
+    return dir;
 }
 
 // MAIN LOOP: check for input and update the game state
 void game_mainloop(GameState* state)
 {
-    // Wait for the first game frame
-    wait_usec(state->tick_time_start);
+    // The attract mode has a loop of its own
+    if (state->demo)
+    {
+        demo_mainloop(state);
+        return;
+    }
+
+    // Schedule the first game frame
+    // (from then on, each tick is scheduled from the deadline of the previous one, rather than from when it finished)
+    uint64_t deadline = clock_usec() + state->tick_time_start;
+    arm_timer(deadline);
+
+    // Whether the changes of the current tick are drawn (they are not while catching up with missed deadlines)
+    bool draw = true;
     
     // The time between game ticks keeps decreasing up to this amount as the snake grows
     uint64_t max_time_mod = state->tick_time_start - state->tick_time_final;
@@ -376,11 +743,32 @@ void game_mainloop(GameState* state)
     
     while (true)
     {
-        // Keep track of how long it took to update the game state
-        const uint64_t start_time = clock_usec();
-        
-        // Get which direction key the user has pressed
-        SnakeDirection dir = parse_input(state);
+        // Wait for the next tick, while getting which direction key the user has pressed
+        // (the process stays idle until the input, the timer, or a signal arrives)
+        bool resized = false;
+        SnakeDirection dir = wait_next_tick(state, &resized);
+
+        // The snake's area has changed if the terminal was resized, so the speed is calculated again
+        if (resized) time_mod = (state->size * max_time_mod) / state->total_area;
+
+        // Pause while the terminal's window is in the background, then give the user a moment before moving again
+        if (!state->has_focus)
+        {
+            game_suspend(state);
+            deadline = clock_usec() + state->tick_time_start;
+            arm_timer(deadline);
+            continue;
+        }
+
+        // Pause when the ESC key was pressed, then give the user a moment before moving again
+        // (the schedule starts over when resuming, so there are no ticks to catch up with)
+        if (input_escape(state->input))
+        {
+            game_pause(state);
+            deadline = clock_usec() + state->tick_time_start;
+            arm_timer(deadline);
+            continue;
+        }
 
         // The snake accelerates if the user has pressed the same direction the snake is moving
         const bool accelerate = (dir == state->direction);
@@ -390,6 +778,18 @@ void game_mainloop(GameState* state)
         // Then check if the snake has collided with an wall or itself.
         const bool has_collided = move_snake(state, dir);
 
+        // Draw the changes of this tick
+        // (unless the terminal is lagging behind, in which case the changes are merged into the next tick)
+        // While catching up, the draw commands are kept on the list until the next drawn tick.
+        if (draw) render_submit(state->render, state->backend, false);
+
+        #ifdef _WIN32
+        // On Windows, this prevents events other than key presses from cluttering the input buffer.
+        // This is needed because we are checking the event count in order to determine if there's a key to be parsed.
+        // We do not really need to handle those other events on this program.
+        FlushConsoleInputBuffer(state->term->input_handle);
+        #endif
+
         // It is game over if the snake has collided or there are no more empty spaces
         if (has_collided || state->free_area == 0)
         {
@@ -408,12 +808,8 @@ void game_mainloop(GameState* state)
         uint64_t frame_duration = state->tick_time_start - time_mod;
         if (accelerate) frame_duration = frame_duration / SNAKE_ACCEL_FACTOR;
         
-        // Wait through the remaining time
-        const uint64_t elapsed_time = clock_usec() - start_time;
-        if (elapsed_time < frame_duration)
-        {
-            wait_usec(frame_duration - elapsed_time);
-        }
+        // Schedule the next tick
+        draw = schedule_next_tick(state, &deadline, frame_duration);
     }
 }
 
@@ -422,19 +818,34 @@ void game_close(GameState* state)
 {
     // Print the snake's size on exit
     printf(MAIN_SCREEN);
-    if (state->free_area == 0)
+    if (state->demo)
     {
-        printf(TEXT_GREEN "CONGRATULATIONS:" COLOR_RESET " Snake overflow!\n");
+        printf(TEXT_YELLOW "Boards restarted:" COLOR_RESET " %" PRIu64 "\n", state->demo->restarts);
+    }
+    else
+    {
+        if (state->free_area == 0)
+        {
+            printf(TEXT_GREEN "CONGRATULATIONS:" COLOR_RESET " Snake overflow!\n");
+        }
+        printf(TEXT_YELLOW "Final size:" COLOR_RESET " %zu\n", state->size);
     }
-    printf(TEXT_YELLOW "Final size:" COLOR_RESET " %zu\n", state->size);
+    if (state->options.show_stats) print_stats(state);
     fflush(stdout);
     
     // Reset the terminal's properties to the original and free the allocated memory
     cleanup();
     map_destroy(state->keymap);
-    free(state->arena);
-    free(state->snake);
-    free(state);
+    input_destroy(state->input);
+    demo_free(state);
+    packed_destroy(state->packed);
+    screen_destroy(state->screen);
+    render_free(state->render);
+    free(state->render);
+    free(state->backend);
+    board_free(state);
+    free(state->term);
+    free_aligned(state);
     state_ptr = NULL;
 
     #ifdef _WIN32
@@ -445,3 +856,44 @@ void game_close(GameState* state)
     linux_term_flags_set = false;
     #endif // _WIN32
 }
+
+// Print the statistics about the terminal output (when the '--stats' option is used)
+void print_stats(GameState* state)
+{
+    const ScreenBuffer *screen = state->screen;
+    const uint64_t frames = (screen->total_frames > 0) ? screen->total_frames : 1;
+
+    printf(TEXT_YELLOW "Frames drawn:" COLOR_RESET " %" PRIu64 "\n", screen->total_frames);
+    printf(
+        TEXT_YELLOW "Frames skipped:" COLOR_RESET " %" PRIu64 " (terminal was lagging behind)\n",
+        screen->total_skipped
+    );
+    printf(
+        TEXT_YELLOW "Bytes written:" COLOR_RESET " %" PRIu64 " (%" PRIu64 " per frame)\n",
+        screen->out.total_bytes, screen->out.total_bytes / frames
+    );
+    printf(
+        TEXT_YELLOW "Write calls:" COLOR_RESET " %" PRIu64 " (%.2f per frame)\n",
+        screen->out.total_syscalls, (double)screen->out.total_syscalls / frames
+    );
+    printf(
+        TEXT_YELLOW "Color sequences skipped:" COLOR_RESET " %" PRIu64 " (%" PRIu64 " per frame)\n",
+        screen->total_sgr_suppressed, screen->total_sgr_suppressed / frames
+    );
+
+    // CPU time used by the whole program, compared to how long the game has been running
+    const uint64_t cpu_time = cpu_usec();
+    const uint64_t run_time = clock_usec() - state->start_time;
+    printf(
+        TEXT_YELLOW "CPU time:" COLOR_RESET " %.3f s (%.1f%% of %.3f s)\n",
+        cpu_time / 1000000.0, (run_time > 0) ? cpu_time * 100.0 / run_time : 0.0, run_time / 1000000.0
+    );
+    printf(
+        TEXT_YELLOW "Deadlines missed:" COLOR_RESET " %" PRIu64 " (the schedule started over %" PRIu64 " times)\n",
+        state->deadlines_missed, state->schedule_resets
+    );
+    printf(
+        TEXT_YELLOW "Sleep margin:" COLOR_RESET " %" PRIu64 " microseconds (time spent spinning before each frame)\n",
+        sleep_margin
+    );
+}
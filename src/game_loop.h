@@ -6,8 +6,12 @@
 #define SNAKE_START_SIZE 4  // Initial size of the snake
 #define SNAKE_START_SPEED 3     // Snake's speed at the start of the game (unit: spaces per second)
 #define SNAKE_FINAL_SPEED 15    // Snake's speed can increase up to this value as the game progresses
+#define SNAKE_START_CAPACITY 16  // Initial amount of parts that fit on the snake's queue
 #define SNAKE_ACCEL_FACTOR 2    // Snake's speed is multiplied by this value when pressing the direction the snake is facing
-#define SLEEP_MARGIN 15000  // Program wakes up this amount of microseconds before the start of the next frame
+#define SLEEP_MARGIN 15000  // Program wakes up at most this amount of microseconds before the start of the next frame
+#define SLEEP_MARGIN_MIN 20 // Program wakes up at least this amount of microseconds before the start of the next frame
+#define CATCH_UP_TICKS 3    // Up to this amount of late ticks are run without being drawn, before the schedule starts over from the current time
+#define QUERY_TIMEOUT 200000 // Maximum amount of microseconds to wait for the terminal to reply a query
 
 // Keyboard's scan codes to be mapped to a direction
 #define SCANCODE_UP    17   // `W` key when on a QWERTY keyboard
@@ -15,10 +19,23 @@
 #define SCANCODE_DOWN  31   // `S` key when on a QWERTY keyboard
 #define SCANCODE_RIGHT 32   // `D` key when on a QWERTY keyboard
 
+typedef struct GameOptions GameOptions;
 typedef struct GameState GameState;
+typedef struct TermState TermState;
 typedef struct GameCoord GameCoord;
 typedef struct KeyMap KeyMap;
-typedef enum SnakeDirection {DIR_NONE=0, DIR_UP, DIR_DOWN, DIR_RIGHT, DIR_LEFT} SnakeDirection;
+typedef struct InputBuffer InputBuffer;
+typedef struct ScreenBuffer ScreenBuffer;
+typedef struct RenderList RenderList;
+typedef struct RenderBackend RenderBackend;
+typedef struct PackedScreen PackedScreen;
+typedef struct DemoState DemoState;
+typedef struct FreeSpaces FreeSpaces;
+typedef enum SnakeDirection {DIR_NONE=0, DIR_UP, DIR_DOWN, DIR_RIGHT, DIR_LEFT, DIR_COUNT} SnakeDirection;
+
+// How many cells of the board go into each cell of the terminal
+// (one, two stacked vertically with half blocks, or four on a 2 by 2 grid with quadrant blocks)
+typedef enum PackMode {PACK_NONE=0, PACK_HALF, PACK_QUAD} PackMode;
 
 // Coordinates on the terminal
 // Notes: 1-indexed, top left is (1,1).
@@ -28,27 +45,28 @@ struct GameCoord
     size_t col; // Column number
 };
 
-// Information needed for drawing the game
-// IMPORTANT: all screen coordinates are 1-indexed, because the numbering of the terminal's rows and columns also start at 1.
-struct GameState
+// Space of the board, as a linear index: (row - 1) * stride + (col - 1)
+// The game logic works on these indices (the stride is the one of the collision grid, see bit_grid.h),
+// and they are converted to coordinates only for drawing.
+typedef uint32_t GameCell;
+#define NO_CELL UINT32_MAX  // Value of a GameCell that is not on the board
+
+// Settings passed to the game through the command line
+struct GameOptions
 {
-    bool **arena;               // (2D array) Collision grid for the game area ('true' means a occupied space)
-    GameCoord *snake;           // (double-ended queue) Coordinates of the screen where the snake parts are being drawn
-    KeyMap *keymap;             // Character keys mapped to the directions (can be used in addition to the arrow keys)
-    size_t head;                // Index of .snake[] where the head is
-    size_t tail;                // Index of .snake[] where the tail is
-    size_t size;                // Current size of the snake
-    size_t total_area;          // Total amount of spaces inside the snake's area
-    size_t free_area;           // Count of non-blocking spaces on the snake's area
-    GameCoord screen_size;      // Maximum coordinates on the terminal screen
-    GameCoord position;         // Coordinate of the screen where the snake's head is
-    GameCoord position_min;     // Smallest screen coordinate where the snake's head can go
-    GameCoord position_max;     // Biggest screen coordinate where the snake's head can go
-    GameCoord food;             // Screen coordinate of the food pellet
-    SnakeDirection direction;   // Direction the snake is moving to
-    uint64_t tick_time_start;   // Duration (in microseconds) at the game's start for each drawn frame 
-    uint64_t tick_time_final;   // The sleep time can decrease up to this value as the game progresses
+    unsigned int speed;     // Value from 1 to 12 for setting the initial snake's speed (5 is the default)
+    bool show_stats;        // Print statistics about the terminal output when the game closes
+    bool dec_graphics;      // Draw the lines with DEC Special Graphics (1 byte per character) instead of UTF-8
+    PackMode pack_mode;     // Pack more than one board cell into each terminal cell, for a bigger board on the same screen
+    unsigned int demo_boards;   // Amount of boards played by the autopilot on the attract mode (0 for a regular game)
+    bool run_checks;        // (debugging) Run the checks of the game's modules instead of the game (see run_checks())
+    bool run_benchmarks;    // (debugging) Run the benchmarks instead of the game (see run_benchmarks())
+};
 
+// Settings of the terminal that the game changes, kept in order to restore them when the game closes
+// (they are not needed while the game runs, so they are kept apart from the game state)
+struct TermState
+{
     #ifdef _WIN32
     // Handles and modes for the terminal on Windows
     HANDLE input_handle;    // stdin handle
@@ -68,14 +86,125 @@ struct GameState
     #endif // _WIN32
 };
 
+// Information needed for drawing the game
+// IMPORTANT: all screen coordinates are 1-indexed, because the numbering of the terminal's rows and columns also start at 1.
+//            The spaces of the board (GameCell) are 0-indexed instead, since they are not screen coordinates.
+// Note: the fields used on every tick come first, so they take the first two cache lines of the state.
+//       The state must be allocated with xmalloc_aligned() for those fields to start at a cache line boundary.
+struct ALIGNED(CACHE_LINE_SIZE) GameState
+{
+    /* Fields used on every tick */
+
+    BitGrid arena;              // Collision grid for the game area (a set bit means a occupied space)
+    GameCell *snake;            // (double-ended queue) Space where each snake part is
+    FreeSpaces *free_spaces;    // Empty spaces of the snake's area (a new food pellet goes on one of them)
+    size_t head;                // Index of .snake[] where the head is
+    size_t tail;                // Index of .snake[] where the tail is
+    size_t snake_capacity;      // Amount of parts that fit on .snake[] (it doubles whenever the snake outgrows it)
+    size_t size;                // Current size of the snake
+    size_t free_area;           // Count of non-blocking spaces on the snake's area
+    GameCell position;          // Space where the snake's head is
+    GameCell food;              // Space where the food pellet is (NO_CELL if there is no room left for it)
+    int32_t dir_step[DIR_COUNT];    // Offset of the space when moving in each direction (-stride, +stride, +1, -1)
+    SnakeDirection direction;   // Direction the snake is moving to
+    RenderList *render;         // Draw commands of the current tick (the game logic draws only through them)
+
+    /* Fields used when setting-up the game, or only once in a while */
+
+    size_t total_area;          // Total amount of spaces inside the snake's area
+    KeyMap *keymap;             // Character keys mapped to the directions (can be used in addition to the arrow keys)
+    InputBuffer *input;         // Bytes read from the terminal that were not decoded yet
+    ScreenBuffer *screen;       // Characters on the terminal screen (the draw commands end up on it, then it is flushed once per frame)
+    RenderBackend *backend;     // Where the draw commands are submitted to at the end of each tick
+    PackedScreen *packed;       // (packed board modes only) Board cells packed into the terminal cells, or NULL
+    DemoState *demo;            // (attract mode only) Boards being shown on the screen, or NULL
+    TermState *term;            // Original settings of the terminal (only on the main game state, NULL on the attract mode's boards)
+    GameCoord screen_size;      // Maximum coordinates on the terminal screen
+    GameCoord origin;           // Top left corner on the terminal of the region where the game is (1,1 unless on the attract mode)
+    GameCoord position_min;     // Smallest screen coordinate where the snake's head can go
+    GameCoord position_max;     // Biggest screen coordinate where the snake's head can go
+    GameCoord size_pos;         // Coordinate on the terminal where the snake's size is displayed
+    bool has_focus;             // Whether the terminal's window has focus (the game pauses while it does not)
+    uint64_t tick_time_start;   // Duration (in microseconds) at the game's start for each drawn frame 
+    uint64_t tick_time_final;   // The sleep time can decrease up to this value as the game progresses
+    uint64_t start_time;        // Value of clock_usec() when the game started (for the statistics)
+    uint64_t deadlines_missed;  // Amount of ticks that started after their scheduled time (for the statistics)
+    uint64_t schedule_resets;   // Amount of times that the game fell too far behind, so the schedule started over (for the statistics)
+    GameOptions options;        // Settings passed through the command line
+};
+
 // Set-up the game state and draw the initial screen
-// 'speed' is a value from 1 to 12 for setting the initial snake's speed.
+// 'options->speed' is a value from 1 to 12 for setting the initial snake's speed.
 // 5 is the default speed. 1 is half of the default and 9 is double of the default.
 // Other values are a linear interpolation between those points.
-GameState* game_init(unsigned int speed);
+GameState* game_init(const GameOptions *options);
+
+// Draw a rectangle along the board's borders, and the label of the snake's size below it
+// They are part of the static layer of the screen, which is pre-rendered once then reused on every redraw.
+void draw_board_frame(GameState *state);
+
+// Adapt the game to the current size of the terminal window, after it was resized
+// The board is resized (see board_resize()), then the screen is erased and drawn again from the game state.
+void game_resize(GameState *state);
+
+// Pause the game while the terminal's window does not have focus, without drawing anything
+// The game resumes when the window gets focus again, or when a direction key is pressed.
+// Then the screen is redrawn from what is retained on the screen buffer.
+void game_suspend(GameState *state);
+
+// Pause the game until the ESC key or a direction key is pressed (the game is paused with the ESC key)
+// The timer of the ticks is disarmed, so the process sleeps until the input arrives.
+// The game is drawn normally while paused (such as after the terminal was resized).
+void game_pause(GameState *state);
+
+// Set-up the collision grid, the snake, the food pellet, and the snake's speed
+// The fields .screen_size, .size_pos, .options, and .render of the state must already be set,
+// and the screen must be big enough for the game. The snake and the food are drawn to .render.
+void board_init(GameState *state);
+
+// Flag the borders of the board as walls on the collision grid
+// The board takes the whole .screen_size of the state, except for the margin around it.
+void board_walls(GameState *state);
+
+// Set the offset of the space when moving in each direction, from the stride of the collision grid
+void board_steps(GameState *state);
+
+// Create the list of empty spaces, with all spaces of the snake's area on it
+// The fields .position_min and .position_max of the state must already be set.
+void board_spaces(GameState *state);
+
+// Count the empty spaces of the snake's area on the collision grid, one row at a time (see grid_count_free())
+size_t board_free_area(const GameState *state);
+
+// Change the size of the board to fit a new screen size, keeping the snake and the food pellet on it
+// The collision grid and the snake's queue are reallocated to the new size, and the snake is copied over.
+// When the board shrinks, the snake and the food are moved up and to the left as much as needed for them to fit.
+// The board does not shrink past the snake's extent or below the minimum size for the game,
+// so in those cases it extends beyond the new screen size (and the part outside of the screen is not displayed).
+// If the food pellet ends up outside of the board, it is spawned again. Nothing else is drawn.
+void board_resize(GameState *state, GameCoord screen_size);
+
+// Free the memory used by the collision grid, the list of empty spaces, and the snake
+void board_free(GameState *state);
+
+// Move the deadline of the next tick forward by the given duration, then set the timer to it (see arm_timer())
+// The deadlines do not depend on how long each tick took, so the ticks keep the same rate on the long run.
+// When the deadline has already passed, it is counted as missed and the next tick starts right away without being drawn
+// (so the game catches up), unless it is more than CATCH_UP_TICKS behind, in which case the schedule starts over from now.
+// Returns whether the next tick should be drawn.
+bool schedule_next_tick(GameState *state, uint64_t *deadline, uint64_t duration);
+
+// Wait until the timer of the next tick expires, while taking the input as soon as it arrives
+// Returns the first direction key that was pressed (the input that arrives after it is left for the next ticks).
+// If the terminal is resized, the game is adapted to the new size while waiting (then 'true' is stored on 'resized').
+// The wait only ends early if the window lost focus, so the schedule of the ticks is kept.
+SnakeDirection wait_next_tick(GameState *state, bool *resized);
 
 // MAIN LOOP: check for input and update the game state
 void game_mainloop(GameState* state);
 
 // Return to the main terminal screen, print the size, and free the memory used by the game
 void game_close(GameState* state);
+
+// Print the statistics about the terminal output (when the '--stats' option is used)
+void print_stats(GameState* state);
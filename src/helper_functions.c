@@ -3,36 +3,69 @@
 // Remember the game state for clean-up purposes
 GameState *state_ptr = NULL;
 
+// How many microseconds before the deadline that wait_until_usec() wakes up, then it spins through the rest of the time
+// (it adapts to how late the sleeps have been waking up)
+uint64_t sleep_margin = SLEEP_MARGIN;
+
 #ifdef _WIN32
 // Whether virtual terminal sequences were already enabled on Windows console
 bool windows_vt_seq = false;
 #else
 // Whether the program has already changed the attributes of the terminal on Linux
 bool linux_term_flags_set = false;
+
+// Timer that expires shortly before the deadline of the next tick (see arm_timer()), or -1 if it was not created
+int timer_fd = -1;
+
+// Descriptor from which the SIGWINCH (terminal resized) and SIGTERM (closing) signals are read, or -1 if it was not created
+// (those signals are blocked, so they only arrive through it)
+int signal_fd = -1;
+#endif // _WIN32
+
+// Deadline of the timer (on the clock_usec() timebase), or 0 if the timer is not armed
+static uint64_t timer_deadline = 0;
+
+#ifndef _WIN32
+// Descriptor that the game's input is read from (see input_create()), or stdin if there is no input buffer
+static int input_fd()
+{
+    return (state_ptr && state_ptr->input) ? state_ptr->input->fd : STDIN_FILENO;
+}
+
+// Exit the program if poll() reported that the terminal's input was closed
+// (otherwise the input's descriptor would be always ready, so the waits would spin instead of sleeping)
+static void check_input_closed(short revents)
+{
+    if (revents & (POLLHUP | POLLERR | POLLNVAL)) printf_error_exit(ERR_INPUT_CLOSED, "The terminal's input was closed.");
+}
 #endif // _WIN32
 
 // Reset the terminal and its window back to their original states
 void cleanup(void)
 {
+    // Finish writing any frame that the terminal was lagging behind
+    // (so the sequences below do not end up in the middle of an incomplete escape sequence)
+    if (state_ptr && state_ptr->screen) output_flush(&state_ptr->screen->out, true);
+
     // Exit the game screen then return to the main terminal screen
     #ifdef _WIN32
-    if (windows_vt_seq) printf(TERM_RESET MAIN_SCREEN);
+    if (windows_vt_seq) printf(FOCUS_REPORT_OFF TERM_RESET MAIN_SCREEN);
     #else
-    printf(TERM_RESET MAIN_SCREEN);
+    printf(FOCUS_REPORT_OFF TERM_RESET MAIN_SCREEN);
     #endif // _WIN32
     fflush(stdout);
 
     // Reset the terminal's settings back to the original
-    if (!state_ptr) return;
+    if (!state_ptr || !state_ptr->term) return;
     #ifdef _WIN32
-    SetWindowLong(state_ptr->window, GWL_STYLE, state_ptr->window_mode_old);
-    SetConsoleOutputCP(state_ptr->output_cp_old);
-    SetConsoleMode(state_ptr->input_handle, state_ptr->input_mode_old);
-    SetConsoleMode(state_ptr->output_handle, state_ptr->output_mode_old);
+    SetWindowLong(state_ptr->term->window, GWL_STYLE, state_ptr->term->window_mode_old);
+    SetConsoleOutputCP(state_ptr->term->output_cp_old);
+    SetConsoleMode(state_ptr->term->input_handle, state_ptr->term->input_mode_old);
+    SetConsoleMode(state_ptr->term->output_handle, state_ptr->term->output_mode_old);
     windows_vt_seq = false;
 
     #else // Linux
-    if (linux_term_flags_set) tcsetattr(STDIN_FILENO, TCSANOW, &state_ptr->term_flags_old);
+    if (linux_term_flags_set) tcsetattr(STDIN_FILENO, TCSANOW, &state_ptr->term->term_flags_old);
 
     #endif // _WIN32
 }
@@ -130,32 +163,41 @@ void* xmalloc(size_t size)
     return ptr;
 }
 
-// Allocate memory for a two dimensional array and initialize its elements to zero
-// Layout: array[height][width]
-// Note: the returned pointer can be passed to free() to get the entire array freed at once.
-void** alloc_2Darray(size_t width, size_t height, size_t element_size)
+// Allocate memory that starts at a cache line boundary, initialized to zero
+// Note: program exits on failure. The memory must be freed with free_aligned().
+void* xmalloc_aligned(size_t size)
 {
-    if (width == 0 || height == 0)
+    if (size == 0)
     {
-        printf_error_exit(ERR_INVALID_ARGS, "2D array must not have an width or a height of zero.");
+        printf_error_exit(ERR_INVALID_ARGS, "Tried to allocate zero bytes of memory.");
     }
-    
-    const size_t col_size = sizeof(void*) * height;
-    const size_t row_size = width * element_size;
-    const size_t total_size = col_size + (height * row_size);
 
-    // The 2D array is a sequence of row pointers followed by the elements themselves
-    void** array = xmalloc(total_size);
-    
-    // Add the row pointers to the array
-    uintptr_t row_address = (uintptr_t)array + col_size;
-    for (size_t i = 0; i < height; i++)
+    // The size of an aligned block must be a multiple of the alignment
+    size = (size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+
+    #ifdef _WIN32
+    void* ptr = _aligned_malloc(size, CACHE_LINE_SIZE);
+    #else
+    void* ptr = aligned_alloc(CACHE_LINE_SIZE, size);
+    #endif // _WIN32
+
+    if (!ptr)
     {
-        array[i] = (void*)row_address;
-        row_address += row_size;
+        printf_error_exit(ERR_NO_MEMORY, "Not enough memory.");
     }
-    
-    return array;
+
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+// Free memory allocated by xmalloc_aligned()
+void free_aligned(void *ptr)
+{
+    #ifdef _WIN32
+    _aligned_free(ptr);
+    #else
+    free(ptr);
+    #endif // _WIN32
 }
 
 // Move in-place a coordinate by a certain offset in the given direction
@@ -185,10 +227,22 @@ extern inline void move_coord(GameCoord *coord, SnakeDirection dir, size_t offse
     }
 }
 
+// (debugging) State of the xorshift generator used by xrand() after it was given a fixed seed (zero if it was not)
+static uint32_t xrand_state = 0;
+
 // Generate a pseudo-random unsigned integer from 0 to UINT_MAX (on Windows) or 2^31 - 1 (on Linux)
 // Note: this function uses the entropy source from the operating system, so seeding is not needed.
 unsigned int xrand()
 {
+    if (xrand_state)
+    {
+        // Fixed sequence (see xrand_seed())
+        xrand_state ^= xrand_state << 13;
+        xrand_state ^= xrand_state >> 17;
+        xrand_state ^= xrand_state << 5;
+        return xrand_state >> 1;
+    }
+
     #ifdef _WIN32
     unsigned int out = 0;
     rand_s(&out);   // Note: this function does not need manual seeding
@@ -224,6 +278,14 @@ unsigned int xrand()
     #endif
 }
 
+// (debugging) Make xrand() return the same numbers on every run and platform, starting from the given seed
+// The numbers then come from a xorshift generator (from 0 to 2^31 - 1), instead of the operating system.
+// A seed of zero goes back to the operating system's generator.
+void xrand_seed(uint32_t seed)
+{
+    xrand_state = seed;
+}
+
 // Check if there is any input to be read from stdin
 bool input_available()
 {
@@ -248,18 +310,19 @@ bool input_available()
     return false;
 }
 
-// Get a character from stdin without blocking if there is no input available
-// (return EOF in such case)
-int getchar_nb()
+// Wait until there is input available on stdin
+// On Linux, it also returns when a signal arrives (see terminal_resized()), and it exits if the input was closed.
+void wait_input()
 {
-    if ( input_available() )
-    {
-        return getchar();
-    }
-    else
-    {
-        return EOF;
-    }
+    #ifdef _WIN32
+    WaitForSingleObject(state_ptr->term->input_handle, INFINITE);
+    #else
+    struct pollfd descriptors[2] = {
+        {.fd = input_fd(), .events = POLLIN},
+        {.fd = signal_fd, .events = POLLIN},    // Negative descriptors are ignored by poll()
+    };
+    if (poll(descriptors, 2, -1) > 0) check_input_closed(descriptors[0].revents);
+    #endif // _WIN32
 }
 
 // Get the amount of microseconds since an unespecified point of time
@@ -298,34 +361,356 @@ uint64_t clock_usec()
 // Return after the given amount of microseconds
 void wait_usec(uint64_t time)
 {
-    uint64_t start = clock_usec();
+    wait_until_usec(clock_usec() + time);
+}
 
-    if (time > SLEEP_MARGIN)
+// Adapt the sleep margin to how late the program woke up from a sleep that was meant to end at the given time
+// Twice how late it woke up is taken as the margin for the next sleeps:
+// the margin goes up right away if the sleep was later than that, otherwise it slowly goes down.
+static void adapt_sleep_margin(uint64_t wake_time)
+{
+    const uint64_t now = clock_usec();
+    const uint64_t lateness = (now > wake_time) ? now - wake_time : 0;
+    const uint64_t target = lateness * 2;
+    if (target > sleep_margin) sleep_margin = target;
+    else sleep_margin -= (sleep_margin - target) / 16;
+
+    if (sleep_margin > SLEEP_MARGIN) sleep_margin = SLEEP_MARGIN;
+    if (sleep_margin < SLEEP_MARGIN_MIN) sleep_margin = SLEEP_MARGIN_MIN;
+}
+
+// Return once clock_usec() reaches the given deadline
+// The program sleeps until shortly before the deadline, then it spins through the remaining time.
+// How early it wakes up (the sleep margin) adapts to how late the previous sleeps woke up.
+void wait_until_usec(uint64_t deadline)
+{
+    uint64_t now = clock_usec();
+
+    if (deadline > now + sleep_margin)
     {
+        const uint64_t wake_time = deadline - sleep_margin;
+
         #ifdef _WIN32
-        SleepEx( (time - SLEEP_MARGIN) / 1000, FALSE );
+        SleepEx((DWORD)((wake_time - now) / 1000), FALSE);
         #else // Linux
-        usleep(time - SLEEP_MARGIN);
-        #endif
+        // Sleep until an absolute time, so the time spent before sleeping does not add to it
+        // (the clock is the same one used by clock_usec())
+        const struct timespec wake = {
+            .tv_sec = wake_time / 1000000,
+            .tv_nsec = (wake_time % 1000000) * 1000,
+        };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR) continue;
+        #endif // _WIN32
+
+        adapt_sleep_margin(wake_time);
     }
-    
-    while (clock_usec() - start < time) continue;
+
+    while (clock_usec() < deadline) continue;
+}
+
+// Set the timer to expire at the given deadline (on the clock_usec() timebase), replacing the previous deadline
+// A deadline of zero disarms the timer. A deadline that has already passed makes the timer expire right away.
+void arm_timer(uint64_t deadline)
+{
+    timer_deadline = deadline;
+
+    #ifndef _WIN32
+    if (timer_fd < 0) return;
+
+    // The timer expires a margin before the deadline (a zero expiration time would disarm it, so it is at least 1)
+    const uint64_t wake_time = (deadline > sleep_margin) ? deadline - sleep_margin : 1;
+    struct itimerspec timer = {0};
+    if (deadline > 0)
+    {
+        timer.it_value.tv_sec = wake_time / 1000000;
+        timer.it_value.tv_nsec = (wake_time % 1000000) * 1000;
+    }
+    LINUX_ERROR_CHECK(timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &timer, NULL));
+    #endif // _WIN32
 }
 
-// Reset the terminal size to the original values
-// Note: this function is meant to be called when the terminal window is resized on Linux (SIGWINCH signal)
-void restore_term(int signal)
+// Wait until an event happens, then return which events happened (see EventFlags)
+// The process is idle while waiting: the timer is set to expire a margin before its deadline (see wait_until_usec()),
+// then the remaining time is spun through. 'take_input' tells whether to return when there is input available on stdin
+// (otherwise the input is left there for later). Signals are only returned on Linux, where it exits if the input was closed.
+unsigned int wait_event(bool take_input)
 {
-    if (!state_ptr) return;
-    printf(RESIZE_SCREEN(%zu,%zu) HIDE_CURSOR, state_ptr->screen_size.row, state_ptr->screen_size.col);
+    unsigned int events = 0;
+
+    #ifdef _WIN32
+    while (events == 0)
+    {
+        // The timer is kept by counting down the time left on the wait for the input
+        DWORD timeout = INFINITE;
+        const uint64_t now = clock_usec();
+        if (timer_deadline > 0)
+        {
+            const uint64_t wake_time = (timer_deadline > sleep_margin) ? timer_deadline - sleep_margin : 0;
+            timeout = (wake_time > now) ? (DWORD)((wake_time - now) / 1000) : 0;
+        }
+
+        if (!take_input)
+        {
+            if (timeout > 0) SleepEx(timeout, FALSE);
+        }
+        else if (WaitForSingleObject(state_ptr->term->input_handle, timeout) == WAIT_OBJECT_0)
+        {
+            // The input handle is also signaled by events other than key presses, which we do not need
+            if (input_available()) events |= EVENT_INPUT;
+            else FlushConsoleInputBuffer(state_ptr->term->input_handle);
+        }
+
+        if (timer_deadline > 0 && clock_usec() + sleep_margin >= timer_deadline) events |= EVENT_TIMER;
+    }
+
+    #else // Linux
+    struct pollfd descriptors[3] = {
+        {.fd = take_input ? input_fd() : -1, .events = POLLIN},    // Negative descriptors are ignored by poll()
+        {.fd = timer_fd, .events = POLLIN},
+        {.fd = signal_fd, .events = POLLIN},
+    };
+    while (poll(descriptors, 3, -1) == -1)
+    {
+        if (errno != EINTR) printf_error_exit(errno, "Failed to wait for events (%s).", strerror(errno));
+    }
+
+    check_input_closed(descriptors[0].revents);
+    if (descriptors[0].revents & POLLIN) events |= EVENT_INPUT;
+    if (descriptors[2].revents) events |= EVENT_SIGNAL;
+    if (descriptors[1].revents)
+    {
+        // Empty the count of expirations, so the timer is not reported again until it is armed again
+        uint64_t expirations;
+        const ssize_t count = read(timer_fd, &expirations, sizeof(expirations));
+        (void)count;    // If there is nothing to be read, the timer was armed again after it expired
+        if (timer_deadline > 0) events |= EVENT_TIMER;
+    }
+
+    #endif // _WIN32
+
+    // Spin through the time left after the timer expired
+    if (events & EVENT_TIMER)
+    {
+        const uint64_t deadline = timer_deadline;
+        timer_deadline = 0;
+        adapt_sleep_margin((deadline > sleep_margin) ? deadline - sleep_margin : 0);
+        while (clock_usec() < deadline) continue;
+    }
+
+    return events;
+}
+
+// Get the amount of microseconds of CPU time that the program has used so far (on both user and kernel modes)
+uint64_t cpu_usec()
+{
+    #ifdef _WIN32
+    FILETIME creation_time, exit_time, kernel_time, user_time;
+    WINDOWS_ERROR_CHECK(GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time));
+
+    // The times are counted in units of 100 nanoseconds
+    const uint64_t kernel = ((uint64_t)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime;
+    const uint64_t user = ((uint64_t)user_time.dwHighDateTime << 32) | user_time.dwLowDateTime;
+    return (kernel + user) / 10;
+
+    #else // Linux
+    struct rusage usage;
+    LINUX_ERROR_CHECK(getrusage(RUSAGE_SELF, &usage));
+    return (uint64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+         + (uint64_t)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+
+    #endif // _WIN32
+}
+
+// Send a query to the terminal and read its reply into a NUL terminated string
+// The primary device attributes are also queried after the given query. Since all terminals reply to it,
+// we can stop waiting as soon as that reply arrives, even if the terminal has ignored the given query.
+// Returns the amount of bytes read. It gives up after QUERY_TIMEOUT microseconds without a complete reply.
+// Note: on Windows no query is sent and zero is returned.
+size_t terminal_query(const char *query, char *reply, size_t reply_size)
+{
+    if (!reply || reply_size == 0) return 0;
+    reply[0] = '\0';
+
+    #ifdef _WIN32
+    /* Note: The replies would arrive mixed with the keyboard events of the console's input buffer,
+       and the Windows console does not reply to all the queries. So we are not querying it. */
+    return 0;
+
+    #else // Linux
+    printf("%s" QUERY_ATTRIBUTES, query);
     fflush(stdout);
+
+    const uint64_t deadline = clock_usec() + QUERY_TIMEOUT;
+    size_t size = 0;
+    
+    while (size < reply_size - 1)
+    {
+        // Wait for the reply until the deadline
+        const uint64_t now = clock_usec();
+        if (now >= deadline) break;
+        const uint64_t remaining = deadline - now;
+        
+        fd_set descriptors = {0};
+        FD_ZERO(&descriptors);
+        FD_SET(STDIN_FILENO, &descriptors);
+        struct timeval timeout = {
+            .tv_sec = remaining / 1000000,
+            .tv_usec = remaining % 1000000,
+        };
+        if (select(STDIN_FILENO+1, &descriptors, NULL, NULL, &timeout) != 1) break;
+
+        const ssize_t count = read(STDIN_FILENO, &reply[size], reply_size - 1 - size);
+        if (count <= 0) break;
+        size += count;
+        reply[size] = '\0';
+
+        // Stop once the reply to the device attributes arrives (it is the last one, and it ends with 'c')
+        const char *attributes = strrchr(reply, '\x1b');
+        if (attributes && strncmp(attributes, CSI "?", 3) == 0 && reply[size-1] == 'c')
+        {
+            break;
+        }
+    }
+
+    return size;
+
+    #endif // _WIN32
+}
+
+// Check whether the terminal supports synchronized output (DEC private mode 2026)
+// Note: the terminal is only queried the first time this function is called, then the result is reused.
+bool terminal_has_sync_output()
+{
+    static bool has_queried = false;
+    static bool is_supported = false;
+    if (has_queried) return is_supported;
+
+    char reply[64];
+    terminal_query(QUERY_SYNC_OUTPUT, reply, sizeof(reply));
+
+    // Reply format: ESC[?2026;<value>$y
+    // Values: 0 = not recognized, 1 = set, 2 = reset, 3 = permanently set, 4 = permanently reset
+    const char *mode = strstr(reply, CSI "?2026;");
+    if (mode)
+    {
+        const char value = mode[sizeof(CSI "?2026;") - 1];
+        is_supported = (value == '1' || value == '2' || value == '3');
+    }
+
+    has_queried = true;
+    return is_supported;
+}
+
+// Print a text starting from the first column of the current row, then get in which column the cursor ended up
+// Returns the column (1-indexed), or 0 if the terminal did not report the cursor's position.
+// Note: the text is left on the screen, so this should be called before the screen gets cleared.
+size_t terminal_probe_column(const char *text)
+{
+    char query[64];
+    snprintf(query, sizeof(query), "\r%s" GET_CURSOR_POS, text);
+
+    char reply[64];
+    terminal_query(query, reply, sizeof(reply));
+
+    // Reply format: ESC[<row>;<column>R
+    const char *report = strstr(reply, CSI);
+    while (report)
+    {
+        size_t row = 0, col = 0;
+        char end = '\0';
+        if (sscanf(report, CSI "%zu;%zu%c", &row, &col, &end) == 3 && end == 'R')
+        {
+            return col;
+        }
+        report = strstr(report + 1, CSI);
+    }
+
+    return 0;
+}
+
+// Check whether the terminal supports repeating the previous character (REP sequence)
+// This is tested by printing a blank space followed by a request to repeat it twice,
+// then checking if the cursor has moved by three columns.
+// Note: the terminal is only tested the first time this function is called, then the result is reused.
+bool terminal_has_rep()
+{
+    static bool has_queried = false;
+    static bool is_supported = false;
+    if (has_queried) return is_supported;
+
+    // The cursor ends on column 4 if the blank space was printed three times,
+    // or on column 2 if the terminal ignored the REP sequence
+    is_supported = (terminal_probe_column(" " REPEAT_CHAR(2)) == 4);
+
+    has_queried = true;
+    return is_supported;
+}
+
+// Check whether the terminal decodes its output as UTF-8
+// This is tested by printing a line drawing character (3 bytes long), then checking if the cursor has moved by one column.
+// If the terminal did not report the cursor's position, it is assumed to be using UTF-8.
+// Note: the terminal is only tested the first time this function is called, then the result is reused.
+bool terminal_has_utf8()
+{
+    static bool has_queried = false;
+    static bool is_supported = true;
+    if (has_queried) return is_supported;
+
+    const size_t column = terminal_probe_column(u8"─");
+    is_supported = (column == 0 || column == 2);
+
+    has_queried = true;
+    return is_supported;
+}
+
+// Check whether the terminal window was resized since the last call, by reading the signals that arrived
+// If the program was asked to close (SIGTERM signal), it exits from here.
+// Note: on Windows this always returns 'false', because resizing the window is disabled while the game runs.
+bool terminal_resized()
+{
+    #ifdef _WIN32
+    return false;
+    #else
+    if (signal_fd < 0) return false;
+
+    // Read all signals, since several resizes in a row only need to be handled once
+    bool resized = false;
+    struct signalfd_siginfo info;
+    while (read(signal_fd, &info, sizeof(info)) == sizeof(info))
+    {
+        if (info.ssi_signo == SIGTERM) exit(SIGTERM);   // Closing through task manager
+        if (info.ssi_signo == SIGWINCH) resized = true;
+    }
+    return resized;
+    #endif // _WIN32
+}
+
+// Get the amount of rows and columns that are visible on the terminal window
+GameCoord terminal_size(GameState *state)
+{
+    #ifdef _WIN32
+    CONSOLE_SCREEN_BUFFER_INFO buffer_info = {0};
+    WINDOWS_ERROR_CHECK(GetConsoleScreenBufferInfo(state->term->output_handle, &buffer_info));
+    return (GameCoord){
+        buffer_info.srWindow.Bottom - buffer_info.srWindow.Top + 1,
+        buffer_info.srWindow.Right - buffer_info.srWindow.Left + 1,
+    };
+    #else
+    (void)state;    // Only needed on Windows
+    struct winsize term_size = {0};
+    LINUX_ERROR_CHECK(ioctl(STDOUT_FILENO, TIOCGWINSZ, &term_size));
+    return (GameCoord){
+        term_size.ws_row,
+        term_size.ws_col,
+    };
+    #endif // _WIN32
 }
 
 // Discard all the data remaining on the standard input stream
 void flush_stdin()
 {
     #ifdef _WIN32
-    FlushConsoleInputBuffer(state_ptr->input_handle);
+    FlushConsoleInputBuffer(state_ptr->term->input_handle);
     #else
     tcflush(STDIN_FILENO, TCIFLUSH);
     #endif
@@ -350,30 +735,74 @@ bool parse_uint(const char* string, unsigned int* out)
     return false;
 }
 
-// Parse the speed value from the program's arguments
+// Parse the game's settings from the program's arguments
 // Note: program exits on failure
-unsigned int parse_speed(int argc, char** argv)
+GameOptions parse_args(int argc, char** argv)
 {
-    if (argc > 1)
+    GameOptions options = {
+        .speed = 5,
+        .show_stats = false,
+        .dec_graphics = false,
+        .pack_mode = PACK_NONE,
+        .demo_boards = 0,
+        .run_checks = false,
+        .run_benchmarks = false,
+    };
+    bool has_speed = false;
+
+    for (int i = 1; i < argc; i++)
     {
-        if (argc == 2)
+        unsigned int value;
+        if (strcmp(argv[i], "--stats") == 0)
         {
-            unsigned int out;
-            if (parse_uint(argv[1], &out))
-            {
-                if (out >= 1 && out <= 12) return out;
-                else goto fail;
-            }
-            else goto fail;
+            options.show_stats = true;
+        }
+        else if (strcmp(argv[i], "--dec") == 0)
+        {
+            options.dec_graphics = true;
+        }
+        else if (strcmp(argv[i], "--half") == 0)
+        {
+            options.pack_mode = PACK_HALF;
+        }
+        else if (strcmp(argv[i], "--quad") == 0)
+        {
+            options.pack_mode = PACK_QUAD;
+        }
+        else if (strcmp(argv[i], "--demo") == 0 && i + 1 < argc && parse_uint(argv[i+1], &value) && value >= 1)
+        {
+            options.demo_boards = value;
+            i++;
+        }
+        else if (strcmp(argv[i], "--test") == 0)
+        {
+            options.run_checks = true;
+        }
+        else if (strcmp(argv[i], "--bench") == 0)
+        {
+            options.run_benchmarks = true;
+        }
+        else if (!has_speed && parse_uint(argv[i], &value) && value >= 1 && value <= 12)
+        {
+            options.speed = value;
+            has_speed = true;
         }
         else
         {
-            fail:
             printf(
-                "Please pass a value from 1 to 12 as the only argument to this program in order to set the game's speed.\n\n"
+                "Please pass a value from 1 to 12 as an argument to this program in order to set the game's speed.\n\n"
                 "Example:\n\t%s 10\n\n"
                 "The greater the value, the faster the snake moves.\n"
                 "5 is the default speed. 1 is half of it, 9 is twice it.\n\n"
+                "Options:\n"
+                "\t--stats\tShow statistics about the terminal output when exiting the game.\n"
+                "\t--dec\tDraw the lines with the terminal's DEC Special Graphics characters, which take less bytes.\n"
+                "\t\t(this is done automatically if the terminal does not seem to support UTF-8)\n"
+                "\t--half\tPack two cells of the board into each character (stacked vertically), for a bigger board.\n"
+                "\t--quad\tPack four cells of the board into each character (on a 2 by 2 grid), for an even bigger board.\n"
+                "\t--demo N\tAttract mode: show N boards at once, all of them played automatically (any key exits).\n"
+                "\t--test\tRun the checks of the game's modules, then exit (with a non-zero status if any of them failed).\n"
+                "\t--bench\tRun the benchmarks, then exit.\n\n"
                 "This game was programmed by Tiago Becerra Paolini, and is licensed under the MIT License.\n\n"
                 "Author's e-mail: tpaolini@gmail.com\n"
                 "Source code: https://github.com/tbpaolini/terminal-snake\n"
@@ -385,7 +814,7 @@ unsigned int parse_speed(int argc, char** argv)
         }
     }
     
-    return 5;
+    return options;
 }
 
 // (debugging) Save the current collision grid to a text file
@@ -396,12 +825,13 @@ void save_collision_grid(GameState *state, const char* path)
     {
         for (size_t col = 0; col < state->screen_size.col; col++)
         {
-            if ((row+1 == state->food.row) && (col+1 == state->food.col))
+            const GameCell cell = row * state->arena.stride + col;
+            if (cell == state->food)
             {
                 fprintf(f, "*");    // Show the food pellet's position
             }
  
-            fprintf(f, "%d", state->arena[row][col]);
+            fprintf(f, "%d", grid_get(&state->arena, cell));
         }
         fprintf(f, "\n");
     }
@@ -451,6 +881,7 @@ void debug_movement()
         if (dir)
         {
             move_snake(state_ptr, dir);
+            render_submit(state_ptr->render, state_ptr->backend, false);
         }
 
         // Sleep for 5 milliseconds before checking for input again
@@ -461,3 +892,381 @@ void debug_movement()
         #endif
     }
 }
+
+// (debugging) Create a game state for a board of the given size, which is played by the autopilot (see fixture_tick())
+// The draw commands go to the given backend. If a screen is given, the board's frame is drawn on it
+// (the backend should then be the one of that screen), and the screen is destroyed along with the state.
+// Returns NULL if the board is too small for the game.
+static GameState* fixture_create(size_t rows, size_t cols, RenderBackend backend, ScreenBuffer *screen)
+{
+    const size_t size_cutoff = 2 * (SCREEN_MARGIN + SNAKE_START_SIZE + 1);
+    if (rows <= size_cutoff || cols <= size_cutoff) return NULL;
+
+    GameState *state = xmalloc_aligned(sizeof(GameState));
+    state->screen_size = (GameCoord){rows, cols};
+    state->origin = (GameCoord){1, 1};
+    state->options = (GameOptions){.speed = 5};
+    state->screen = screen;
+    state->render = xmalloc(sizeof(RenderList));
+    render_init(state->render);
+    state->backend = xmalloc(sizeof(RenderBackend));
+    *state->backend = backend;
+
+    if (screen) draw_board_frame(state);
+    board_init(state);
+    if (screen) screen_redraw(screen);
+    render_submit(state->render, state->backend, true);
+
+    return state;
+}
+
+// (debugging) Move the snake of a fixture by one tick with the autopilot
+// The changes are submitted to the backend if 'draw' is set (otherwise they are kept until the next drawn tick).
+// A new game starts when the snake collides or fills the board. Returns whether a new game was started.
+static bool fixture_tick(GameState *state, bool draw)
+{
+    const bool has_collided = move_snake(state, autopilot(state));
+    if (draw) render_submit(state->render, state->backend, false);
+    if (!has_collided && state->free_area > 0) return false;
+
+    erase_game(state);
+    board_free(state);
+    board_init(state);
+    return true;
+}
+
+// (debugging) Free the memory used by a fixture, including its screen (if it has one)
+static void fixture_destroy(GameState *state)
+{
+    if (!state) return;
+    board_free(state);
+    screen_destroy(state->screen);
+    render_free(state->render);
+    free(state->render);
+    free(state->backend);
+    free_aligned(state);
+}
+
+// (debugging) Run the game for the given amount of ticks, with the snake being moved by the autopilot
+// The draw commands go to a backend that discards them, so the simulation runs at full speed without any output.
+// A new game starts whenever the snake collides. The amount of ticks per second is printed.
+void simulate_benchmark(size_t rows, size_t cols, size_t ticks)
+{
+    GameState *state = fixture_create(rows, cols, render_backend_null(), NULL);
+    if (!state) return;
+
+    size_t games = 1;
+    const uint64_t start_time = clock_usec();
+
+    for (size_t i = 0; i < ticks; i++)
+    {
+        if (fixture_tick(state, true)) games++;
+    }
+
+    const uint64_t elapsed = clock_usec() - start_time;
+    printf(
+        "Board: %zu x %zu\n"
+        "Ticks simulated: %zu\n"
+        "Games played: %zu\n"
+        "Ticks per second: %.0f\n",
+        rows, cols,
+        ticks,
+        games,
+        (elapsed > 0) ? (double)ticks * 1000000.0 / elapsed : 0.0
+    );
+
+    fixture_destroy(state);
+}
+
+// (debugging) Serial line that transmits the bytes it receives at a fixed rate (see throttled_output_check())
+typedef struct SerialLine
+{
+    uint64_t bytes_per_sec;     // Transmission rate
+    uint64_t capacity;          // Most bytes that can be waiting at once (like the transmit buffer of a serial port's driver)
+    uint64_t queued;            // Amount of bytes waiting to be transmitted
+    uint64_t drain_time;        // Value of clock_usec() up to when the transmission of the queue was accounted for
+    uint64_t max_queued;        // Biggest amount of bytes that were waiting at once
+} SerialLine;
+
+// (debugging) Function with the signature of OutputSink, for passing an output buffer's bytes to a serial line
+// The bytes that the line had time to transmit since the last call are removed from its queue,
+// then the new bytes are added to it (as many as fit on the line's capacity).
+static size_t serial_sink(void *context, const char *bytes, size_t size, size_t *queued)
+{
+    (void)bytes;
+    SerialLine *line = context;
+    const uint64_t now = clock_usec();
+
+    const uint64_t sent = (now - line->drain_time) * line->bytes_per_sec / 1000000;
+    if (sent >= line->queued)
+    {
+        line->queued = 0;
+        line->drain_time = now;
+    }
+    else
+    {
+        // Only the time of the whole bytes that were transmitted is accounted for
+        line->queued -= sent;
+        line->drain_time += sent * 1000000 / line->bytes_per_sec;
+    }
+
+    const size_t taken = (size < line->capacity - line->queued) ? size : line->capacity - line->queued;
+    line->queued += taken;
+    if (line->queued > line->max_queued) line->max_queued = line->queued;
+    *queued = line->queued;
+    return taken;
+}
+
+// (debugging) Check that the game stays on schedule while its output goes through a slow serial line
+// The game is played by the autopilot for the given amount of ticks, in real time at the snake's final speed.
+// The line transmits at the given baud rate (10 bits per byte), and its queue stands for the terminal's output queue,
+// so the frames are skipped the same way as when the terminal is lagging (see output_lagging() and screen_flush()).
+// The check fails if any deadline was missed, or if more than MAX_SKIPPED_FRAMES frames in a row were skipped.
+// The frames that were skipped (coalesced into a later one) and the line's longest queue are printed too.
+// Returns whether the check passed.
+bool throttled_output_check(size_t rows, size_t cols, size_t ticks, unsigned int baud)
+{
+    if (baud < 10) return false;
+    SerialLine line = {.bytes_per_sec = baud / 10, .capacity = 4096, .drain_time = clock_usec()};
+
+    // The whole screen is drawn at first, so the line starts with a long queue
+    ScreenBuffer *screen = screen_create(rows, cols);
+    output_set_sink(&screen->out, &serial_sink, &line);
+    GameState *state = fixture_create(rows, cols, render_backend_screen(screen), screen);
+    if (!state)
+    {
+        screen_destroy(screen);
+        return false;
+    }
+
+    const uint64_t tick_time = state->tick_time_final;
+    const uint64_t start_frames = screen->total_frames;
+    size_t games = 1;
+    size_t ticks_not_drawn = 0;     // Ticks skipped while catching up with the missed deadlines
+    size_t max_skipped_row = 0;     // Most frames skipped in a row because the line was lagging
+
+    uint64_t deadline = clock_usec() + tick_time;
+    bool draw = true;
+
+    for (size_t i = 0; i < ticks; i++)
+    {
+        wait_until_usec(deadline);
+
+        if (fixture_tick(state, draw)) games++;
+        if (!draw) ticks_not_drawn++;
+        if (screen->skipped_count > max_skipped_row) max_skipped_row = screen->skipped_count;
+
+        draw = schedule_next_tick(state, &deadline, tick_time);
+    }
+
+    const bool passed = (state->deadlines_missed == 0 && max_skipped_row <= MAX_SKIPPED_FRAMES);
+
+    printf(
+        "Board: %zu x %zu\n"
+        "Line speed: %u baud (%" PRIu64 " bytes per tick)\n"
+        "Ticks played: %zu (%" PRIu64 " microseconds each)\n"
+        "Games played: %zu\n"
+        "Frames drawn: %" PRIu64 "\n"
+        "Frames skipped: %" PRIu64 " (at most %zu in a row, the limit is %d)\n"
+        "Ticks not drawn: %zu (catching up)\n"
+        "Deadlines missed: %" PRIu64 " (the schedule started over %" PRIu64 " times)\n"
+        "Longest queue: %" PRIu64 " bytes (the lagging threshold is %d)\n"
+        "Result: %s\n",
+        rows, cols,
+        baud, line.bytes_per_sec * tick_time / 1000000,
+        ticks, tick_time,
+        games,
+        screen->total_frames - start_frames,
+        screen->total_skipped, max_skipped_row, MAX_SKIPPED_FRAMES,
+        ticks_not_drawn,
+        state->deadlines_missed, state->schedule_resets,
+        line.max_queued, OUTPUT_QUEUE_LIMIT,
+        passed ? "OK" : "FAIL"
+    );
+
+    fixture_destroy(state);
+    return passed;
+}
+
+// (debugging) Run the autopilot for the given amount of ticks, checking after each move that the empty spaces agree
+// The count of empty spaces on the state, the size of the list of empty spaces, and the free spaces on the collision grid
+// (see board_free_area()) should all be the same. The board is also resized every 1000 ticks, shrinking and growing back
+// (see board_resize()). The first mismatch found is printed.
+// Returns whether there were no mismatches.
+bool free_spaces_check(size_t rows, size_t cols, size_t ticks)
+{
+    GameState *state = fixture_create(rows, cols, render_backend_null(), NULL);
+    if (!state) return false;
+
+    size_t games = 1;
+    size_t checked = 0;
+    bool failed = false;
+
+    for (size_t i = 0; i < ticks && !failed; i++)
+    {
+        if (fixture_tick(state, true)) games++;
+
+        if (i % 1000 == 999)
+        {
+            const bool shrink = (state->screen_size.row == rows && state->screen_size.col == cols);
+            board_resize(state, shrink ? (GameCoord){rows - 4, cols - 8} : (GameCoord){rows, cols});
+        }
+
+        const size_t grid_free = board_free_area(state);
+        if (grid_free != state->free_area || state->free_spaces->count != state->free_area)
+        {
+            printf(
+                "Mismatch on tick %zu: free area %zu, list of empty spaces %zu, collision grid %zu\n",
+                i, state->free_area, state->free_spaces->count, grid_free
+            );
+            failed = true;
+        }
+        else checked++;
+    }
+
+    printf(
+        "Board: %zu x %zu\n"
+        "Ticks checked: %zu\n"
+        "Games played: %zu\n"
+        "Result: %s\n",
+        rows, cols,
+        checked,
+        games,
+        failed ? "FAIL" : "OK"
+    );
+
+    fixture_destroy(state);
+    return !failed;
+}
+
+// (debugging) Check the screen of a new game and of the game after one move, against golden frames saved on the given folder
+// The game is drawn on an emulated terminal, with the autopilot moving the snake and xrand() seeded with a fixed value.
+// The golden frames are named 'board_<rows>x<cols>.txt' and 'move_<rows>x<cols>.txt' (with an '_ascii' suffix when
+// SNAKE_ASCII_GLYPHS is defined). If the screen does not match one of them, it is saved next to it with a '.actual' extension.
+// Returns whether both frames matched.
+bool golden_frame_check(size_t rows, size_t cols, const char *folder)
+{
+    #ifdef SNAKE_ASCII_GLYPHS
+    const char *suffix = "_ascii";
+    #else
+    const char *suffix = "";
+    #endif // SNAKE_ASCII_GLYPHS
+
+    xrand_seed(12345);
+    VtEmulator *vt = vt_create(rows, cols);
+    ScreenBuffer *screen = screen_create(rows, cols);
+    output_set_sink(&screen->out, &vt_sink, vt);
+    GameState *state = fixture_create(rows, cols, render_backend_screen(screen), screen);
+    if (!state)
+    {
+        screen_destroy(screen);
+        vt_destroy(vt);
+        xrand_seed(0);
+        return false;
+    }
+
+    const char *names[] = {"board", "move"};
+    bool passed = true;
+    printf("Board: %zu x %zu\n", rows, cols);
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        // The first frame is the new game, then the snake moves once before each of the next ones
+        if (i > 0) fixture_tick(state, true);
+
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s_%zux%zu%s.txt", folder, names[i], rows, cols, suffix);
+        const bool matches = vt_matches_file(vt, path);
+        printf("Frame '%s': %s\n", path, matches ? "OK" : "FAIL");
+
+        if (!matches)
+        {
+            strncat(path, ".actual", sizeof(path) - strlen(path) - 1);
+            if (vt_save(vt, path)) printf("The screen was saved to '%s'\n", path);
+            passed = false;
+        }
+    }
+
+    fixture_destroy(state);
+    vt_destroy(vt);
+    xrand_seed(0);
+    return passed;
+}
+
+// (debugging) Compare the memory of the snake's queue against a queue of coordinates for the whole area
+// The game is run by the autopilot like on simulate_benchmark(), while the biggest size of the snake's queue is recorded.
+// Then it is compared to a queue of GameCoord with one element per space of the snake's area (the layout before the
+// queue of linear indices). Only the memory is compared: move_snake() works on the linear indices, so the old layout
+// can not be run anymore (the speed of move_snake() with the current layout is measured by simulate_benchmark()).
+void snake_queue_memory(size_t rows, size_t cols, size_t ticks)
+{
+    GameState *state = fixture_create(rows, cols, render_backend_null(), NULL);
+    if (!state) return;
+
+    const size_t area = state->total_area;
+    size_t capacity = state->snake_capacity;
+    size_t longest = state->size;
+    size_t games = 1;
+
+    for (size_t i = 0; i < ticks; i++)
+    {
+        // The sizes are taken before the tick, since the queue is allocated again when a new game starts
+        if (state->snake_capacity > capacity) capacity = state->snake_capacity;
+        if (state->size > longest) longest = state->size;
+        if (fixture_tick(state, true)) games++;
+    }
+    if (state->snake_capacity > capacity) capacity = state->snake_capacity;
+    if (state->size > longest) longest = state->size;
+
+    printf(
+        "Board: %zu x %zu\n"
+        "Ticks simulated: %zu\n"
+        "Games played: %zu\n"
+        "Longest snake: %zu parts\n"
+        "Queue of coordinates: %zu bytes (one per space of the snake's area)\n"
+        "Queue of linear indices: %zu bytes (the most that the snake needed)\n",
+        rows, cols,
+        ticks,
+        games,
+        longest,
+        sizeof(GameCoord) * area,
+        sizeof(GameCell) * capacity
+    );
+
+    fixture_destroy(state);
+}
+
+// (debugging) Run the checks of the game's modules, printing the result of each one (this is what the --test option does)
+// Returns whether all checks passed.
+bool run_checks()
+{
+    bool passed = true;
+
+    printf("\n[Empty spaces]\n");
+    passed &= free_spaces_check(24, 80, 100000);
+    passed &= free_spaces_check(40, 200, 100000);
+
+    // The golden frames are on the repository, so the checks should be run from its root folder
+    printf("\n[Golden frames]\n");
+    passed &= golden_frame_check(24, 80, "tests/golden");
+
+    // The first frame takes more than a second to be transmitted, while each tick only has time for about 64 bytes
+    printf("\n[Output on a 9600 baud line]\n");
+    passed &= throttled_output_check(40, 160, 90, 9600);
+
+    printf("\n%s\n", passed ? "All checks passed." : "Some checks FAILED.");
+    return passed;
+}
+
+// (debugging) Run the benchmarks, printing their results (this is what the --bench option does)
+void run_benchmarks()
+{
+    printf("\n[Autopilot]\n");
+    simulate_benchmark(60, 200, 1000000);
+
+    printf("\n[Snake's queue]\n");
+    snake_queue_memory(60, 200, 1000000);
+
+    printf("\n[Emulated terminal]\n");
+    vt_benchmark(60, 200, 100000);
+}
@@ -5,14 +5,33 @@
 // Remember the game state for clean-up purposes
 extern GameState *state_ptr;
 
+// How many microseconds before the deadline that wait_until_usec() wakes up, then it spins through the rest of the time
+// (it adapts to how late the sleeps have been waking up)
+extern uint64_t sleep_margin;
+
 #ifdef _WIN32
 // Whether virtual terminal sequences were already enabled on Windows console
 extern bool windows_vt_seq;
 #else
 // Whether the program has already changed the attributes of the terminal on Linux
 extern bool linux_term_flags_set;
+
+// Timer that expires shortly before the deadline of the next tick (see arm_timer()), or -1 if it was not created
+extern int timer_fd;
+
+// Descriptor from which the SIGWINCH (terminal resized) and SIGTERM (closing) signals are read, or -1 if it was not created
+// (those signals are blocked, so they only arrive through it)
+extern int signal_fd;
 #endif // _WIN32
 
+// Events that wait_event() returns (they are bit flags, since several events can happen at once)
+typedef enum EventFlags
+{
+    EVENT_INPUT = 1,    // There is input available on stdin
+    EVENT_TIMER = 2,    // The deadline passed to arm_timer() was reached
+    EVENT_SIGNAL = 4,   // A signal arrived (see terminal_resized())
+} EventFlags;
+
 // Reset the terminal and its window back to their original states
 void cleanup(void);
 
@@ -35,10 +54,12 @@ void _Noreturn windows_error_exit(const char* file_name, int line_number);
 // Note: program exits on failure.
 void* xmalloc(size_t size);
 
-// Allocate memory for a two dimensional array and initialize its elements to zero
-// Layout: array[height][width]
-// Note: the returned pointer can be passed to free() to get the entire array freed at once.
-void** alloc_2Darray(size_t width, size_t height, size_t element_size);
+// Allocate memory that starts at a cache line boundary, initialized to zero
+// Note: program exits on failure. The memory must be freed with free_aligned().
+void* xmalloc_aligned(size_t size);
+
+// Free memory allocated by xmalloc_aligned()
+void free_aligned(void *ptr);
 
 // Move in-place a coordinate by a certain offset in the given direction
 inline void move_coord(GameCoord *coord, SnakeDirection dir, size_t offset);
@@ -47,12 +68,17 @@ inline void move_coord(GameCoord *coord, SnakeDirection dir, size_t offset);
 // Note: this function uses the entropy source from the operating system, so seeding is not needed.
 unsigned int xrand();
 
+// (debugging) Make xrand() return the same numbers on every run and platform, starting from the given seed
+// The numbers then come from a xorshift generator (from 0 to 2^31 - 1), instead of the operating system.
+// A seed of zero goes back to the operating system's generator.
+void xrand_seed(uint32_t seed);
+
 // Check if there is any input to be read from stdin
 bool input_available();
 
-// Get a character from stdin without blocking if there is no input available
-// (return EOF in such case)
-int getchar_nb();
+// Wait until there is input available on stdin
+// On Linux, it also returns when a signal arrives (see terminal_resized()), and it exits if the input was closed.
+void wait_input();
 
 // Get the amount of microseconds since an unespecified point of time
 // The difference between two calls of this function should give how long has passed.
@@ -61,9 +87,59 @@ uint64_t clock_usec();
 // Return after the given amount of microseconds
 void wait_usec(uint64_t time);
 
-// Reset the terminal size to the original values
-// Note: this function is meant to be called when the terminal window is resized on Linux (SIGWINCH signal)
-void restore_term(int signal);
+// Return once clock_usec() reaches the given deadline
+// The program sleeps until shortly before the deadline, then it spins through the remaining time.
+// How early it wakes up (the sleep margin) adapts to how late the previous sleeps woke up.
+void wait_until_usec(uint64_t deadline);
+
+// Set the timer to expire at the given deadline (on the clock_usec() timebase), replacing the previous deadline
+// A deadline of zero disarms the timer. A deadline that has already passed makes the timer expire right away.
+void arm_timer(uint64_t deadline);
+
+// Wait until an event happens, then return which events happened (see EventFlags)
+// The process is idle while waiting: the timer is set to expire a margin before its deadline (see wait_until_usec()),
+// then the remaining time is spun through. 'take_input' tells whether to return when there is input available on stdin
+// (otherwise the input is left there for later). Signals are only returned on Linux, where it exits if the input was closed.
+unsigned int wait_event(bool take_input);
+
+// Get the amount of microseconds of CPU time that the program has used so far (on both user and kernel modes)
+uint64_t cpu_usec();
+
+// Send a query to the terminal and read its reply into a NUL terminated string
+// The primary device attributes are also queried after the given query. Since all terminals reply to it,
+// we can stop waiting as soon as that reply arrives, even if the terminal has ignored the given query.
+// Returns the amount of bytes read. It gives up after QUERY_TIMEOUT microseconds without a complete reply.
+// Note: on Windows no query is sent and zero is returned.
+size_t terminal_query(const char *query, char *reply, size_t reply_size);
+
+// Check whether the terminal supports synchronized output (DEC private mode 2026)
+// Note: the terminal is only queried the first time this function is called, then the result is reused.
+bool terminal_has_sync_output();
+
+// Print a text starting from the first column of the current row, then get in which column the cursor ended up
+// Returns the column (1-indexed), or 0 if the terminal did not report the cursor's position.
+// Note: the text is left on the screen, so this should be called before the screen gets cleared.
+size_t terminal_probe_column(const char *text);
+
+// Check whether the terminal supports repeating the previous character (REP sequence)
+// This is tested by printing a blank space followed by a request to repeat it twice,
+// then checking if the cursor has moved by three columns.
+// Note: the terminal is only tested the first time this function is called, then the result is reused.
+bool terminal_has_rep();
+
+// Check whether the terminal decodes its output as UTF-8
+// This is tested by printing a line drawing character (3 bytes long), then checking if the cursor has moved by one column.
+// If the terminal did not report the cursor's position, it is assumed to be using UTF-8.
+// Note: the terminal is only tested the first time this function is called, then the result is reused.
+bool terminal_has_utf8();
+
+// Check whether the terminal window was resized since the last call, by reading the signals that arrived
+// If the program was asked to close (SIGTERM signal), it exits from here.
+// Note: on Windows this always returns 'false', because resizing the window is disabled while the game runs.
+bool terminal_resized();
+
+// Get the amount of rows and columns that are visible on the terminal window
+GameCoord terminal_size(GameState *state);
 
 // Discard all the data remaining on the standard input stream
 void flush_stdin();
@@ -73,9 +149,9 @@ void flush_stdin();
 //       The string must end after the last digit, and start with a digit or blank spaces.
 bool parse_uint(const char* string, unsigned int* out);
 
-// Parse the speed value from the program's arguments
+// Parse the game's settings from the program's arguments
 // Note: program exits on failure
-unsigned int parse_speed(int argc, char** argv);
+GameOptions parse_args(int argc, char** argv);
 
 // (debugging) Save the current collision grid to a text file
 void save_collision_grid(GameState *state, const char* path);
@@ -85,3 +161,45 @@ void debug_keys();
 
 // (debugging) Move the snake freely with the keyboard
 void debug_movement();
+
+// (debugging) Run the game for the given amount of ticks, with the snake being moved by the autopilot
+// The draw commands go to a backend that discards them, so the simulation runs at full speed without any output.
+// A new game starts whenever the snake collides. The amount of ticks per second is printed.
+void simulate_benchmark(size_t rows, size_t cols, size_t ticks);
+
+// (debugging) Check that the game stays on schedule while its output goes through a slow serial line
+// The game is played by the autopilot for the given amount of ticks, in real time at the snake's final speed.
+// The line transmits at the given baud rate (10 bits per byte), and its queue stands for the terminal's output queue,
+// so the frames are skipped the same way as when the terminal is lagging (see output_lagging() and screen_flush()).
+// The check fails if any deadline was missed, or if more than MAX_SKIPPED_FRAMES frames in a row were skipped.
+// The frames that were skipped (coalesced into a later one) and the line's longest queue are printed too.
+// Returns whether the check passed.
+bool throttled_output_check(size_t rows, size_t cols, size_t ticks, unsigned int baud);
+
+// (debugging) Run the autopilot for the given amount of ticks, checking after each move that the empty spaces agree
+// The count of empty spaces on the state, the size of the list of empty spaces, and the free spaces on the collision grid
+// (see board_free_area()) should all be the same. The board is also resized every 1000 ticks, shrinking and growing back
+// (see board_resize()). The first mismatch found is printed.
+// Returns whether there were no mismatches.
+bool free_spaces_check(size_t rows, size_t cols, size_t ticks);
+
+// (debugging) Check the screen of a new game and of the game after one move, against golden frames saved on the given folder
+// The game is drawn on an emulated terminal, with the autopilot moving the snake and xrand() seeded with a fixed value.
+// The golden frames are named 'board_<rows>x<cols>.txt' and 'move_<rows>x<cols>.txt' (with an '_ascii' suffix when
+// SNAKE_ASCII_GLYPHS is defined). If the screen does not match one of them, it is saved next to it with a '.actual' extension.
+// Returns whether both frames matched.
+bool golden_frame_check(size_t rows, size_t cols, const char *folder);
+
+// (debugging) Compare the memory of the snake's queue against a queue of coordinates for the whole area
+// The game is run by the autopilot like on simulate_benchmark(), while the biggest size of the snake's queue is recorded.
+// Then it is compared to a queue of GameCoord with one element per space of the snake's area (the layout before the
+// queue of linear indices). Only the memory is compared: move_snake() works on the linear indices, so the old layout
+// can not be run anymore (the speed of move_snake() with the current layout is measured by simulate_benchmark()).
+void snake_queue_memory(size_t rows, size_t cols, size_t ticks);
+
+// (debugging) Run the checks of the game's modules, printing the result of each one (this is what the --test option does)
+// Returns whether all checks passed.
+bool run_checks();
+
+// (debugging) Run the benchmarks, printing their results (this is what the --bench option does)
+void run_benchmarks();
@@ -1,5 +1,14 @@
 #pragma once
 
+#define CACHE_LINE_SIZE 64  // Size in bytes of a cache line (on the CPUs the game is expected to run)
+
+// Align a type or a variable to the given amount of bytes
+#ifdef _MSC_VER
+#define ALIGNED(bytes) __declspec(align(bytes))
+#else
+#define ALIGNED(bytes) __attribute__((aligned(bytes)))
+#endif // _MSC_VER
+
 #define WINDOWS_ERROR_CHECK(expr) if (!(expr))\
     {\
         windows_error_exit(__FILE__, __LINE__);\
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdbool.h>
 #include <ctype.h>
 #include <locale.h>
@@ -32,7 +33,12 @@
 #include <unistd.h>
 #include <termios.h>
 #include <sys/ioctl.h>
+#include <sys/resource.h>
 #include <sys/select.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
 #include <fcntl.h>
 #include <linux/uinput.h>
 #include <linux/input.h>
@@ -40,13 +46,22 @@
 #endif // _WIN_32
 
 // Application's headers
+#include "helper_macros.h"
 #include "terminal_sequences.h"
 #include "screen_elements.h"
+#include "bit_grid.h"
 #include "game_loop.h"
+#include "output_buffer.h"
+#include "input_buffer.h"
+#include "screen_buffer.h"
+#include "vt_emulator.h"
+#include "render_list.h"
+#include "packed_screen.h"
+#include "demo_mode.h"
+#include "free_spaces.h"
 #include "game_logic.h"
 #include "helper_functions.h"
 #include "key_mapper.h"
-#include "helper_macros.h"
 
 // Error codes
 #define ERR_NO_MEMORY -1        // Failed to allocate memory
@@ -54,3 +69,5 @@
 #define ERR_ARRAY_OVERFLOW -3   // Tried to access an out-of-bounds coordinate
 #define ERR_INVALID_ARGS -4     // Incorrect command line arguments passed to the program
 #define ERR_KEYMAP_FAIL -5      // Failed to map the keyboard characters to the movement directions
+#define ERR_INPUT_CLOSED -6     // The terminal's input was closed (end of file or hang-up)
+#define ERR_CHECK_FAILED -7     // (debugging) Some of the checks run by the --test option have failed
@@ -0,0 +1,231 @@
+#include "includes.h"
+
+// Direction of the final character of an arrow key's sequence, or DIR_NONE if it is not an arrow key
+static SnakeDirection arrow_direction(uint8_t final)
+{
+    switch (final)
+    {
+        case 'A':
+            return DIR_UP;
+
+        case 'B':
+            return DIR_DOWN;
+
+        case 'C':
+            return DIR_RIGHT;
+
+        case 'D':
+            return DIR_LEFT;
+
+        default:
+            return DIR_NONE;
+    }
+}
+
+// Allocate the memory for an empty input buffer, reading from the standard input without blocking
+InputBuffer* input_create()
+{
+    InputBuffer *input = xmalloc(sizeof(InputBuffer));
+
+    #ifndef _WIN32
+    // Open the standard input again, so we get a file description of our own that can be set to non-blocking
+    // (the same way as the output buffer does with the standard output, see output_set_nonblocking())
+    input->fd = open("/proc/self/fd/0", O_RDONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+    if (input->fd == -1) input->fd = STDIN_FILENO;  // Fall back to stdin, which is only read after poll() says it has input
+    #endif // _WIN32
+
+    return input;
+}
+
+// Read into the buffer the bytes that are available on the terminal, without waiting for more
+// All available bytes are taken with a single call to the operating system (as many as fit on the buffer).
+// Returns the amount of bytes that were read. On Linux, the program exits if the input has reached its end.
+size_t input_read(InputBuffer *input)
+{
+    const size_t space = INPUT_BUFFER_SIZE - (input->tail - input->head);
+    if (space == 0) return 0;
+
+    #ifdef _WIN32
+    size_t count = 0;
+    while (count < space && input_available())
+    {
+        input->data[(input->tail + count) % INPUT_BUFFER_SIZE] = (uint8_t)getchar();
+        count++;
+    }
+
+    #else // Linux
+    // The free space might wrap around the end of the buffer, so it is read as two parts
+    const size_t start = input->tail % INPUT_BUFFER_SIZE;
+    const size_t first = (start + space <= INPUT_BUFFER_SIZE) ? space : INPUT_BUFFER_SIZE - start;
+    struct iovec parts[2] = {
+        {.iov_base = &input->data[start], .iov_len = first},
+        {.iov_base = &input->data[0], .iov_len = space - first},
+    };
+
+    ssize_t count = readv(input->fd, parts, (space > first) ? 2 : 1);
+    if (count < 0) count = 0;   // Nothing available (or interrupted by a signal), so there is nothing to be decoded yet
+    else if (count == 0) printf_error_exit(ERR_INPUT_CLOSED, "The terminal's input was closed.");  // End of file
+
+    #endif // _WIN32
+
+    input->tail += count;
+    input->read_time = clock_usec();
+    return count;
+}
+
+// Decode the bytes on the buffer until a direction key is found
+// The arrow keys are recognized in both cursor key modes, and the other keys through the given key map (which can be NULL).
+// The focus reports update 'has_focus' along the way. The bytes after the direction are kept for the next call.
+// Returns the direction, or DIR_NONE if there was none on the buffer
+// (then the bytes of an incomplete sequence are taken, and the decoding continues from them on the next call).
+SnakeDirection input_parse(InputBuffer *input, const KeyMap *keymap, bool *has_focus)
+{
+    while (input->head != input->tail)
+    {
+        const uint8_t byte = input->data[input->head % INPUT_BUFFER_SIZE];
+        input->head++;
+        SnakeDirection dir = DIR_NONE;
+
+        switch (input->stage)
+        {
+            case INPUT_GROUND:
+                if (byte == '\x1b')
+                {
+                    input->stage = INPUT_ESCAPE;
+                    input->esc_time = input->read_time;
+                    break;
+                }
+
+                input->keys++;
+                if (keymap && keymap->next[byte])
+                {
+                    // Start of the byte sequence of a mapped key
+                    input->node = keymap->next[byte];
+                    dir = input->node->dir;
+                    input->stage = (dir == DIR_NONE) ? INPUT_KEYMAP : INPUT_GROUND;
+                }
+                break;
+
+            case INPUT_ESCAPE:
+                // The ESC was the ESC key if the next byte arrived too late or is another ESC
+                // (then the byte is decoded again from the ground stage)
+                if (byte == '\x1b' || input->read_time - input->esc_time >= ESC_TIMEOUT)
+                {
+                    input->escapes++;
+                    input->keys++;
+                    input->stage = INPUT_GROUND;
+                    input->head--;
+                    break;
+                }
+
+                // Only the SS3 and CSI sequences are used, the other characters after an ESC are ignored
+                if (byte == 'O') input->stage = INPUT_SS3;
+                else if (byte == '[') input->stage = INPUT_CSI;
+                else
+                {
+                    input->stage = INPUT_GROUND;
+                    input->keys++;  // A key pressed along with the Alt key
+                }
+                input->csi_params = false;
+                break;
+
+            case INPUT_SS3:
+                input->keys++;
+                dir = arrow_direction(byte);
+                input->stage = INPUT_GROUND;
+                break;
+
+            case INPUT_CSI:
+                // Parameter and intermediate bytes (the arrow keys have parameters when pressed along with a modifier key)
+                if (byte >= 0x20 && byte <= 0x3F)
+                {
+                    input->csi_params = true;
+                    break;
+                }
+
+                input->stage = INPUT_GROUND;
+                if (byte < 0x40 || byte > 0x7E)
+                {
+                    input->head--;  // Not part of the sequence, so the byte is decoded again from the ground stage
+                }
+                else if (!input->csi_params && byte == FOCUS_IN_FINAL)
+                {
+                    *has_focus = true;
+                }
+                else if (!input->csi_params && byte == FOCUS_OUT_FINAL)
+                {
+                    *has_focus = false;
+                }
+                else
+                {
+                    input->keys++;
+                    dir = arrow_direction(byte);
+                }
+                break;
+
+            case INPUT_KEYMAP:
+                // Move to the trie's next node
+                input->node = input->node->next[byte];
+                if (!input->node)
+                {
+                    input->stage = INPUT_GROUND;
+                    input->head--;  // The sequence did not match, so the byte is decoded again from the ground stage
+                    break;
+                }
+
+                dir = input->node->dir;
+                if (dir != DIR_NONE) input->stage = INPUT_GROUND;
+                break;
+
+            default:
+                input->stage = INPUT_GROUND;
+                break;
+        }
+
+        if (dir != DIR_NONE) return dir;
+    }
+
+    return DIR_NONE;
+}
+
+// Whether the ESC key was pressed (rather than an ESC that starts a sequence), then forget one press of it
+// An ESC is taken as the key when nothing arrives for ESC_TIMEOUT microseconds after it, or when another ESC follows it.
+bool input_escape(InputBuffer *input)
+{
+    if (input->stage == INPUT_ESCAPE && clock_usec() - input->esc_time >= ESC_TIMEOUT)
+    {
+        input->escapes++;
+        input->keys++;
+        input->stage = INPUT_GROUND;
+    }
+
+    if (input->escapes == 0) return false;
+    input->escapes--;
+    return true;
+}
+
+// Time (on the clock_usec() timebase) when the ESC waiting on the decoder is going to be taken as the ESC key,
+// or 0 if the decoder is not waiting on an ESC
+uint64_t input_escape_deadline(const InputBuffer *input)
+{
+    return (input->stage == INPUT_ESCAPE) ? input->esc_time + ESC_TIMEOUT : 0;
+}
+
+// Discard the bytes on the buffer and any incomplete sequence
+void input_discard(InputBuffer *input)
+{
+    input->head = input->tail;
+    input->stage = INPUT_GROUND;
+}
+
+// Free the memory used by an input buffer
+void input_destroy(InputBuffer *input)
+{
+    if (!input) return;
+
+    #ifndef _WIN32
+    if (input->fd != STDIN_FILENO) close(input->fd);
+    #endif // _WIN32
+
+    free(input);
+}
@@ -0,0 +1,65 @@
+// Input read in bulk into a ring buffer, then decoded by a state machine that resumes where it stopped
+
+#pragma once
+
+#include "includes.h"
+
+#define INPUT_BUFFER_SIZE 256   // Amount of bytes that the input's ring buffer can hold (must be a power of two)
+#define ESC_TIMEOUT 50000       // An ESC followed by nothing for this amount of microseconds is taken as the ESC key
+
+// Which part of a sequence the input parser has reached
+typedef enum InputStage
+{
+    INPUT_GROUND = 0,   // Not inside a sequence
+    INPUT_ESCAPE,       // After an ESC character
+    INPUT_SS3,          // After "ESC O" (the arrow keys on the cursor keys application mode)
+    INPUT_CSI,          // After "ESC [" (the arrow keys on the normal mode, and the focus reports)
+    INPUT_KEYMAP,       // Inside the byte sequence of a mapped key
+} InputStage;
+
+// Bytes read from the terminal that were not decoded yet, and the state of the decoder
+typedef struct InputBuffer
+{
+    uint8_t data[INPUT_BUFFER_SIZE];    // Ring buffer of the bytes
+    size_t head;            // Position of the next byte to be decoded (taken modulo the buffer's size)
+    size_t tail;            // Position after the last byte that was read (taken modulo the buffer's size)
+    InputStage stage;       // Part of a sequence that the decoder has reached
+    bool csi_params;        // (INPUT_CSI only) Whether the sequence has parameters (such as the modifier keys)
+    const KeyMap *node;     // (INPUT_KEYMAP only) Node of the key map's trie reached so far
+    uint64_t esc_time;      // (INPUT_ESCAPE only) Value of clock_usec() when the bytes with the ESC were read
+    uint64_t read_time;     // Value of clock_usec() when the bytes were last read
+    unsigned int escapes;   // Amount of times that the ESC key was pressed and not yet taken (see input_escape())
+    size_t keys;            // Amount of keys decoded so far, of any kind (the focus reports are not counted)
+    #ifndef _WIN32
+    int fd;                 // File descriptor where the bytes are read from (a non-blocking duplicate of stdin, or stdin itself)
+    #endif // _WIN32
+} InputBuffer;
+
+// Allocate the memory for an empty input buffer, reading from the standard input without blocking
+InputBuffer* input_create();
+
+// Read into the buffer the bytes that are available on the terminal, without waiting for more
+// All available bytes are taken with a single call to the operating system (as many as fit on the buffer).
+// Returns the amount of bytes that were read. On Linux, the program exits if the input has reached its end.
+size_t input_read(InputBuffer *input);
+
+// Decode the bytes on the buffer until a direction key is found
+// The arrow keys are recognized in both cursor key modes, and the other keys through the given key map (which can be NULL).
+// The focus reports update 'has_focus' along the way. The bytes after the direction are kept for the next call.
+// Returns the direction, or DIR_NONE if there was none on the buffer
+// (then the bytes of an incomplete sequence are taken, and the decoding continues from them on the next call).
+SnakeDirection input_parse(InputBuffer *input, const KeyMap *keymap, bool *has_focus);
+
+// Whether the ESC key was pressed (rather than an ESC that starts a sequence), then forget one press of it
+// An ESC is taken as the key when nothing arrives for ESC_TIMEOUT microseconds after it, or when another ESC follows it.
+bool input_escape(InputBuffer *input);
+
+// Time (on the clock_usec() timebase) when the ESC waiting on the decoder is going to be taken as the ESC key,
+// or 0 if the decoder is not waiting on an ESC
+uint64_t input_escape_deadline(const InputBuffer *input);
+
+// Discard the bytes on the buffer and any incomplete sequence
+void input_discard(InputBuffer *input);
+
+// Free the memory used by an input buffer
+void input_destroy(InputBuffer *input);
@@ -16,14 +16,32 @@
 
 #include "includes.h"
 #include "helper_functions.c"
+#include "bit_grid.c"
 #include "game_loop.c"
 #include "game_logic.c"
+#include "output_buffer.c"
+#include "input_buffer.c"
+#include "screen_buffer.c"
+#include "vt_emulator.c"
+#include "render_list.c"
+#include "packed_screen.c"
+#include "demo_mode.c"
+#include "free_spaces.c"
 #include "key_mapper.c"
 
 int main(int argc, char **argv)
 {
-    unsigned int speed = parse_speed(argc, argv);
-    GameState* state = game_init(speed);
+    GameOptions options = parse_args(argc, argv);
+
+    // Debugging options, which run instead of the game
+    if (options.run_checks) return run_checks() ? 0 : ERR_CHECK_FAILED;
+    if (options.run_benchmarks)
+    {
+        run_benchmarks();
+        return 0;
+    }
+
+    GameState* state = game_init(&options);
     game_mainloop(state);
     game_close(state);
     
@@ -0,0 +1,198 @@
+#include "includes.h"
+
+// Allocate the memory for an output buffer with the given initial capacity
+// The buffer starts writing to the standard output, where writing blocks until all bytes are taken.
+void output_init(OutputBuffer *out, size_t capacity)
+{
+    *out = (OutputBuffer){0};
+    out->capacity = (capacity > 0) ? capacity : 1;
+    out->data = xmalloc(out->capacity);
+
+    #ifndef _WIN32
+    out->fd = STDOUT_FILENO;
+    #endif // _WIN32
+}
+
+// Make the buffer write to the terminal without blocking, so it can keep a backlog when the terminal is slow
+// Note: on Windows this does nothing.
+void output_set_nonblocking(OutputBuffer *out)
+{
+    #ifndef _WIN32
+    if (out->fd != STDOUT_FILENO) return;   // Already set
+
+    // Open the standard output again, so we get a file description of our own that can be set to non-blocking.
+    // (setting stdout itself to non-blocking would also affect stdin, since both usually share the same description)
+    out->fd = open("/proc/self/fd/1", O_WRONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+    if (out->fd == -1) out->fd = STDOUT_FILENO;   // Fall back to blocking writes
+    #endif // _WIN32
+}
+
+// Send the output to a function instead of the terminal (or back to the terminal, if 'sink' is NULL)
+// The function takes the bytes the same way as the terminal (it might take only part of them when it is slow),
+// and it tells how many bytes it still has queued (which stands for the terminal's output queue, see output_lagging()).
+// This is meant for running the game's output through an emulated terminal (see vt_emulator.h) or a simulated slow line.
+void output_set_sink(OutputBuffer *out, OutputSink sink, void *context)
+{
+    out->sink = sink;
+    out->sink_context = context;
+}
+
+// Ensure that the buffer can hold at least the given amount of extra bytes without being resized
+void output_reserve(OutputBuffer *out, size_t extra)
+{
+    if (out->size + extra <= out->capacity) return;
+
+    // Double the capacity until the extra bytes fit
+    size_t new_capacity = out->capacity * 2;
+    while (new_capacity < out->size + extra) new_capacity *= 2;
+
+    out->data = realloc(out->data, new_capacity);
+    if (!out->data)
+    {
+        printf_error_exit(ERR_NO_MEMORY, "Not enough memory.");
+    }
+    out->capacity = new_capacity;
+}
+
+// Append a sequence of bytes to the buffer
+extern inline void output_append(OutputBuffer *out, const char *bytes, size_t size)
+{
+    output_reserve(out, size);
+    memcpy(&out->data[out->size], bytes, size);
+    out->size += size;
+}
+
+// Append a single byte to the buffer
+extern inline void output_append_byte(OutputBuffer *out, char byte)
+{
+    output_reserve(out, 1);
+    out->data[out->size++] = byte;
+}
+
+// Append the decimal representation of an unsigned integer to the buffer
+extern inline void output_append_uint(OutputBuffer *out, size_t value)
+{
+    // Write the digits from right to left on a temporary buffer
+    // (20 digits is enough for the biggest 64-bit value)
+    char digits[20];
+    size_t pos = sizeof(digits);
+    do
+    {
+        digits[--pos] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    output_append(out, &digits[pos], sizeof(digits) - pos);
+}
+
+// Write the bytes on the buffer to the terminal
+// If 'wait' is false, only the bytes that the terminal can take right away are written,
+// and the remaining ones are kept at the start of the buffer as a backlog to be written on the next flush.
+// If 'wait' is true, it only returns after all bytes were written.
+// Returns the amount of bytes that were written.
+size_t output_flush(OutputBuffer *out, bool wait)
+{
+    size_t written = 0;
+    uint64_t syscalls = 0;
+
+    // Pass the bytes to the sink, if there is one (like the terminal, it might take only part of them)
+    while (out->sink && written < out->size)
+    {
+        size_t queued = 0;
+        const size_t count = out->sink(out->sink_context, &out->data[written], out->size - written, &queued);
+        written += count;
+        if (count > 0) continue;
+        if (!wait) break;
+        wait_usec(1000);    // Give the sink some time to make room for more bytes
+    }
+
+    // Keep writing until all bytes were written
+    // (the operating system might accept only part of the bytes on each call)
+    while (!out->sink && written < out->size)
+    {
+        #ifdef _WIN32
+        DWORD count = 0;
+        syscalls++;
+        if (!WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), &out->data[written], out->size - written, &count, NULL))
+        {
+            // Discard the bytes if writing has failed, since the terminal is not accepting them
+            written = out->size;
+            break;
+        }
+
+        #else // Linux
+        const ssize_t count = write(out->fd, &out->data[written], out->size - written);
+        syscalls++;
+        if (count < 0)
+        {
+            if (errno == EINTR) continue;   // Interrupted by a signal before anything was written, so try again
+            
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                // The terminal is not taking any more bytes for now
+                if (!wait) break;
+                
+                // Sleep until the terminal can take more bytes
+                struct pollfd descriptor = {.fd = out->fd, .events = POLLOUT};
+                poll(&descriptor, 1, -1);
+                continue;
+            }
+            
+            // Discard the bytes if writing has failed, since the terminal is not accepting them
+            written = out->size;
+            break;
+        }
+
+        #endif // _WIN32
+
+        if (count == 0) break;
+        written += count;
+    }
+
+    // Move the bytes that were not written to the start of the buffer
+    out->size -= written;
+    if (out->size > 0) memmove(out->data, &out->data[written], out->size);
+    out->backlog = out->size;
+
+    // Update the output statistics
+    out->frame_bytes = written;
+    out->frame_syscalls = syscalls;
+    out->total_bytes += written;
+    out->total_syscalls += syscalls;
+
+    return written;
+}
+
+// Whether the terminal is lagging behind the output
+// That is the case when there are bytes from a previous flush that the terminal did not take yet,
+// or when the terminal's output queue (or the sink's queue) has more than OUTPUT_QUEUE_LIMIT bytes still waiting to be transmitted.
+bool output_lagging(const OutputBuffer *out)
+{
+    if (out->backlog > 0) return true;
+    if (out->sink)
+    {
+        size_t queued = 0;
+        out->sink(out->sink_context, NULL, 0, &queued);
+        return queued > OUTPUT_QUEUE_LIMIT;
+    }
+
+    #ifdef _WIN32
+    return false;
+
+    #else // Linux
+    int queued = 0;
+    if (ioctl(out->fd, TIOCOUTQ, &queued) == -1) return false;
+    return queued > OUTPUT_QUEUE_LIMIT;
+
+    #endif // _WIN32
+}
+
+// Free the memory used by an output buffer
+void output_free(OutputBuffer *out)
+{
+    #ifndef _WIN32
+    if (out->fd != STDOUT_FILENO) close(out->fd);
+    #endif // _WIN32
+    free(out->data);
+    *out = (OutputBuffer){0};
+}
@@ -0,0 +1,78 @@
+// Bytes of each frame, assembled on our own buffer then written to the terminal with a single call
+
+#pragma once
+
+#include "includes.h"
+
+#define OUTPUT_QUEUE_LIMIT 1024 // The terminal is considered to be lagging if its output queue has more than this amount of bytes
+
+// Append a string literal (or a macro that expands to one) to an output buffer
+// Note: the size of the literal is calculated at compile time.
+#define OUTPUT_LITERAL(out, literal) output_append((out), (literal), sizeof(literal) - 1)
+
+// Function that receives the output instead of the terminal (see output_set_sink())
+// It takes as many of the bytes as it can, and returns that amount. The amount of bytes that are still waiting
+// on its side is stored on 'queued'. It is also called with zero bytes, for just getting that amount.
+typedef size_t (*OutputSink)(void *context, const char *bytes, size_t size, size_t *queued);
+
+// Growable buffer of bytes to be written to the terminal
+typedef struct OutputBuffer
+{
+    char *data;         // Bytes waiting to be written
+    size_t size;        // Amount of bytes on .data[]
+    size_t capacity;    // Maximum amount of bytes that .data[] can hold before being resized
+    size_t backlog;     // Amount of bytes at the start of .data[] that the terminal did not take on the last flush
+
+    #ifndef _WIN32
+    int fd;             // File descriptor where the bytes are written to (stdout, or a non-blocking duplicate of it)
+    #endif // _WIN32
+    OutputSink sink;    // If set, the bytes are passed to this function instead of being written to the terminal
+    void *sink_context; // Pointer passed as the first argument of .sink()
+
+    // Output statistics
+    uint64_t frame_bytes;       // Amount of bytes written on the last flush
+    uint64_t frame_syscalls;    // Amount of calls to the operating system on the last flush
+    uint64_t total_bytes;       // Amount of bytes written on all flushes
+    uint64_t total_syscalls;    // Amount of calls to the operating system on all flushes
+} OutputBuffer;
+
+// Allocate the memory for an output buffer with the given initial capacity
+// The buffer starts writing to the standard output, where writing blocks until all bytes are taken.
+void output_init(OutputBuffer *out, size_t capacity);
+
+// Make the buffer write to the terminal without blocking, so it can keep a backlog when the terminal is slow
+// Note: on Windows this does nothing.
+void output_set_nonblocking(OutputBuffer *out);
+
+// Send the output to a function instead of the terminal (or back to the terminal, if 'sink' is NULL)
+// The function takes the bytes the same way as the terminal (it might take only part of them when it is slow),
+// and it tells how many bytes it still has queued (which stands for the terminal's output queue, see output_lagging()).
+// This is meant for running the game's output through an emulated terminal (see vt_emulator.h) or a simulated slow line.
+void output_set_sink(OutputBuffer *out, OutputSink sink, void *context);
+
+// Ensure that the buffer can hold at least the given amount of extra bytes without being resized
+void output_reserve(OutputBuffer *out, size_t extra);
+
+// Append a sequence of bytes to the buffer
+inline void output_append(OutputBuffer *out, const char *bytes, size_t size);
+
+// Append a single byte to the buffer
+inline void output_append_byte(OutputBuffer *out, char byte);
+
+// Append the decimal representation of an unsigned integer to the buffer
+inline void output_append_uint(OutputBuffer *out, size_t value);
+
+// Write the bytes on the buffer to the terminal
+// If 'wait' is false, only the bytes that the terminal can take right away are written,
+// and the remaining ones are kept at the start of the buffer as a backlog to be written on the next flush.
+// If 'wait' is true, it only returns after all bytes were written.
+// Returns the amount of bytes that were written.
+size_t output_flush(OutputBuffer *out, bool wait);
+
+// Whether the terminal is lagging behind the output
+// That is the case when there are bytes from a previous flush that the terminal did not take yet,
+// or when the terminal's output queue (or the sink's queue) has more than OUTPUT_QUEUE_LIMIT bytes still waiting to be transmitted.
+bool output_lagging(const OutputBuffer *out);
+
+// Free the memory used by an output buffer
+void output_free(OutputBuffer *out);
@@ -0,0 +1,240 @@
+#include "includes.h"
+
+// Block characters indexed by which quarters of the terminal cell are filled
+// (bit 0: top left, bit 1: top right, bit 2: bottom left, bit 3: bottom right)
+static const ScreenCell block_cells[16] = {
+    CELL_INIT(" ", CELL_GRAY),
+    CELL_INIT(BLOCK_TOP_LEFT, CELL_GRAY),
+    CELL_INIT(BLOCK_TOP_RIGHT, CELL_GRAY),
+    CELL_INIT(BLOCK_TOP, CELL_GRAY),
+    CELL_INIT(BLOCK_BOTTOM_LEFT, CELL_GRAY),
+    CELL_INIT(BLOCK_LEFT, CELL_GRAY),
+    CELL_INIT(BLOCK_DIAGONAL_UP, CELL_GRAY),
+    CELL_INIT(BLOCK_NOT_BOTTOM_RIGHT, CELL_GRAY),
+    CELL_INIT(BLOCK_BOTTOM_RIGHT, CELL_GRAY),
+    CELL_INIT(BLOCK_DIAGONAL_DOWN, CELL_GRAY),
+    CELL_INIT(BLOCK_RIGHT, CELL_GRAY),
+    CELL_INIT(BLOCK_NOT_BOTTOM_LEFT, CELL_GRAY),
+    CELL_INIT(BLOCK_BOTTOM, CELL_GRAY),
+    CELL_INIT(BLOCK_NOT_TOP_RIGHT, CELL_GRAY),
+    CELL_INIT(BLOCK_NOT_TOP_LEFT, CELL_GRAY),
+    CELL_INIT(BLOCK_FULL, CELL_GRAY),
+};
+
+// Which color wins when board cells of different colors share the same terminal cell (the highest value wins)
+// The food pellet and the collided head stand out over the snake's body, which stands out over the walls.
+static const uint8_t color_priority[] = {
+    [CELL_GRAY] = 0,
+    [CELL_GREEN] = 1,
+    [CELL_CYAN] = 2,
+    [CELL_WHITE] = 2,
+    [CELL_YELLOW] = 3,
+    [CELL_RED] = 4,
+};
+
+// Work out the block character of a terminal cell from the board cells that it holds
+static ScreenCell packed_cell(const PackedScreen *packed, size_t row, size_t col)
+{
+    unsigned int mask = 0;  // Filled quarters of the terminal cell
+    uint8_t color = 0;      // Color of the terminal cell (plus one, or 0 if it has no filled quarters)
+
+    for (size_t sub_row = 0; sub_row < packed->pack_rows; sub_row++)
+    {
+        const size_t board_row = (row - 1) * packed->pack_rows + sub_row;
+        if (board_row >= packed->rows) break;
+
+        for (size_t sub_col = 0; sub_col < packed->pack_cols; sub_col++)
+        {
+            const size_t board_col = (col - 1) * packed->pack_cols + sub_col;
+            if (board_col >= packed->cols) break;
+
+            const uint8_t value = packed->cells[board_row * packed->cols + board_col];
+            if (value == 0) continue;
+
+            // On half blocks, a board cell takes both quarters of its half
+            mask |= (packed->pack_cols == 1) ? (3u << (sub_row * 2)) : (1u << (sub_row * 2 + sub_col));
+            if (color == 0 || color_priority[value - 1] > color_priority[color - 1]) color = value;
+        }
+    }
+
+    ScreenCell cell = block_cells[mask];
+    cell.color = (color > 0) ? color - 1 : CELL_GRAY;
+    return cell;
+}
+
+// Add to the static layer a range of terminal cells on the same row, as they look with the current board cells
+// (the consecutive terminal cells that look the same are grouped into a single run)
+static void packed_static_cells(PackedScreen *packed, size_t row, size_t col_first, size_t col_last)
+{
+    size_t col = col_first;
+    while (col <= col_last)
+    {
+        const ScreenCell cell = packed_cell(packed, row, col);
+        size_t count = 1;
+        while (col + count <= col_last)
+        {
+            const ScreenCell next = packed_cell(packed, row, col + count);
+            if (next.size != cell.size || next.color != cell.color || memcmp(next.glyph, cell.glyph, cell.size) != 0) break;
+            count++;
+        }
+
+        screen_static_run(packed->screen, (GameCoord){row, col}, cell, count);
+        col += count;
+    }
+}
+
+// Amount of board rows and columns that fit on a terminal of the given size, when packing the board cells in the given mode
+// (the terminal's last row is not counted, since it is left for the text below the board)
+GameCoord packed_board_size(PackMode mode, size_t rows, size_t cols)
+{
+    const size_t board_rows = (rows > 1) ? rows - 1 : 0;
+    switch (mode)
+    {
+        case PACK_HALF:
+            return (GameCoord){board_rows * 2, cols};
+
+        case PACK_QUAD:
+            return (GameCoord){board_rows * 2, cols * 2};
+
+        default:
+            return (GameCoord){rows, cols};
+    }
+}
+
+// Create the packed board cells over a terminal screen, with all cells empty
+// The board takes the size returned by packed_board_size() for the current size of the screen.
+PackedScreen* packed_create(ScreenBuffer *screen, PackMode mode)
+{
+    PackedScreen *packed = xmalloc(sizeof(PackedScreen));
+    packed->screen = screen;
+    packed->mode = mode;
+    packed->pack_rows = (mode == PACK_HALF || mode == PACK_QUAD) ? 2 : 1;
+    packed->pack_cols = (mode == PACK_QUAD) ? 2 : 1;
+    packed->cells = NULL;
+    packed_resize(packed);
+    return packed;
+}
+
+// Empty all board cells, and change their amount to fit the current size of the screen
+// (this is meant to be called after the screen was resized)
+void packed_resize(PackedScreen *packed)
+{
+    const GameCoord size = packed_board_size(packed->mode, packed->screen->rows, packed->screen->cols);
+    packed->rows = size.row;
+    packed->cols = size.col;
+
+    free(packed->cells);
+    const size_t cell_count = packed->rows * packed->cols;
+    packed->cells = xmalloc(sizeof(typeof(*packed->cells)) * (cell_count > 0 ? cell_count : 1));
+}
+
+// Write a board cell, then update the terminal cell that holds it
+// A blank space empties the board cell, while other characters fill it with their color.
+// When the cells packed on the same terminal cell have different colors, the more noticeable one is used for all of them.
+// Note: coordinates outside of the board are ignored.
+void packed_set(PackedScreen *packed, GameCoord pos, ScreenCell cell)
+{
+    if (pos.row < 1 || pos.row > packed->rows || pos.col < 1 || pos.col > packed->cols) return;
+
+    const bool is_blank = (cell.size == 1 && cell.glyph[0] == ' ');
+    packed->cells[(pos.row - 1) * packed->cols + (pos.col - 1)] = is_blank ? 0 : cell.color + 1;
+
+    const GameCoord term_pos = {
+        (pos.row - 1) / packed->pack_rows + 1,
+        (pos.col - 1) / packed->pack_cols + 1,
+    };
+    screen_set(packed->screen, term_pos, packed_cell(packed, term_pos.row, term_pos.col));
+}
+
+// Add to the static layer of the screen a rectangle of board cells with the given top left and bottom right corners
+// The terminal cells that hold the rectangle's borders are pre-rendered as they look after filling those board cells.
+void packed_static_box(PackedScreen *packed, GameCoord top_left, GameCoord bottom_right, CellColor color)
+{
+    if (bottom_right.row <= top_left.row || bottom_right.col <= top_left.col) return;
+    if (bottom_right.row > packed->rows) bottom_right.row = packed->rows;
+    if (bottom_right.col > packed->cols) bottom_right.col = packed->cols;
+    const uint8_t value = color + 1;
+
+    // Fill the board cells of the borders
+    for (size_t col = top_left.col; col <= bottom_right.col; col++)
+    {
+        packed->cells[(top_left.row - 1) * packed->cols + (col - 1)] = value;
+        packed->cells[(bottom_right.row - 1) * packed->cols + (col - 1)] = value;
+    }
+
+    for (size_t row = top_left.row; row <= bottom_right.row; row++)
+    {
+        packed->cells[(row - 1) * packed->cols + (top_left.col - 1)] = value;
+        packed->cells[(row - 1) * packed->cols + (bottom_right.col - 1)] = value;
+    }
+
+    // Terminal cells where the corners are
+    const GameCoord first = {
+        (top_left.row - 1) / packed->pack_rows + 1,
+        (top_left.col - 1) / packed->pack_cols + 1,
+    };
+    const GameCoord last = {
+        (bottom_right.row - 1) / packed->pack_rows + 1,
+        (bottom_right.col - 1) / packed->pack_cols + 1,
+    };
+
+    // The rows with the top and bottom borders are added entirely, while on the others only the laterals are added
+    for (size_t row = first.row; row <= last.row; row++)
+    {
+        if (row == first.row || row == last.row)
+        {
+            packed_static_cells(packed, row, first.col, last.col);
+        }
+        else
+        {
+            packed_static_cells(packed, row, first.col, first.col);
+            if (last.col != first.col) packed_static_cells(packed, row, last.col, last.col);
+        }
+    }
+}
+
+// Draw the commands to the board cells, then flush the screen to the terminal
+static void packed_submit(void *context, const RenderList *list, bool wait)
+{
+    PackedScreen *packed = context;
+
+    for (size_t i = 0; i < list->count; i++)
+    {
+        const RenderCommand *command = &list->commands[i];
+        switch (command->type)
+        {
+            case RENDER_CELL:
+                packed_set(packed, command->pos, command->cell);
+                break;
+
+            case RENDER_TEXT:
+                screen_text(packed->screen, command->pos, &list->text[command->text_start], command->cell.color);
+                break;
+
+            case RENDER_BELL:
+                screen_write(packed->screen, "\a", 1);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    screen_flush(packed->screen, wait);
+}
+
+// Backend that draws the commands to the board cells, then flushes the screen to the terminal
+// The cells are drawn on board coordinates, while the text is drawn on terminal coordinates (so it is not packed).
+RenderBackend render_backend_packed(PackedScreen *packed)
+{
+    return (RenderBackend){.submit = &packed_submit, .context = packed};
+}
+
+// Free the memory used by the packed board cells
+// Note: the screen is not freed.
+void packed_destroy(PackedScreen *packed)
+{
+    if (!packed) return;
+    free(packed->cells);
+    free(packed);
+}
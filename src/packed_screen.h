@@ -0,0 +1,48 @@
+// Board cells packed two or four per terminal cell, with half or quadrant block characters
+
+#pragma once
+
+#include "includes.h"
+
+// Board cells packed into the terminal cells, with the terminal's last row left for the text below the board
+// Note: the board cells are stored row by row, and (row, col) coordinates passed to the functions are 1-indexed.
+typedef struct PackedScreen
+{
+    ScreenBuffer *screen;   // Terminal screen where the packed cells are drawn to
+    PackMode mode;          // How many board cells go into each terminal cell
+    size_t pack_rows;       // Amount of board rows on each terminal row
+    size_t pack_cols;       // Amount of board columns on each terminal column
+    uint8_t *cells;         // Color of each board cell (a value of CellColor plus one, or 0 for an empty cell)
+    size_t rows;            // Amount of rows on the board
+    size_t cols;            // Amount of columns on the board
+} PackedScreen;
+
+// Amount of board rows and columns that fit on a terminal of the given size, when packing the board cells in the given mode
+// (the terminal's last row is not counted, since it is left for the text below the board)
+GameCoord packed_board_size(PackMode mode, size_t rows, size_t cols);
+
+// Create the packed board cells over a terminal screen, with all cells empty
+// The board takes the size returned by packed_board_size() for the current size of the screen.
+PackedScreen* packed_create(ScreenBuffer *screen, PackMode mode);
+
+// Empty all board cells, and change their amount to fit the current size of the screen
+// (this is meant to be called after the screen was resized)
+void packed_resize(PackedScreen *packed);
+
+// Write a board cell, then update the terminal cell that holds it
+// A blank space empties the board cell, while other characters fill it with their color.
+// When the cells packed on the same terminal cell have different colors, the more noticeable one is used for all of them.
+// Note: coordinates outside of the board are ignored.
+void packed_set(PackedScreen *packed, GameCoord pos, ScreenCell cell);
+
+// Add to the static layer of the screen a rectangle of board cells with the given top left and bottom right corners
+// The terminal cells that hold the rectangle's borders are pre-rendered as they look after filling those board cells.
+void packed_static_box(PackedScreen *packed, GameCoord top_left, GameCoord bottom_right, CellColor color);
+
+// Backend that draws the commands to the board cells, then flushes the screen to the terminal
+// The cells are drawn on board coordinates, while the text is drawn on terminal coordinates (so it is not packed).
+RenderBackend render_backend_packed(PackedScreen *packed);
+
+// Free the memory used by the packed board cells
+// Note: the screen is not freed.
+void packed_destroy(PackedScreen *packed);
@@ -0,0 +1,214 @@
+#include "includes.h"
+
+// Add an empty command to the end of the list, and return a pointer to it
+static RenderCommand* render_push(RenderList *list, RenderCommandType type)
+{
+    if (list->count == list->capacity)
+    {
+        // Double the capacity of the list when it gets full
+        list->capacity *= 2;
+        list->commands = realloc(list->commands, sizeof(typeof(*list->commands)) * list->capacity);
+        if (!list->commands)
+        {
+            printf_error_exit(ERR_NO_MEMORY, "Not enough memory.");
+        }
+    }
+
+    RenderCommand *command = &list->commands[list->count++];
+    *command = (RenderCommand){.type = type};
+    return command;
+}
+
+// Copy a string to the end of the list's text, and return the position where it starts
+static uint32_t render_push_text(RenderList *list, const char *text, size_t size)
+{
+    if (list->text_size + size + 1 > list->text_capacity)
+    {
+        // Double the capacity of the text until the string fits
+        while (list->text_size + size + 1 > list->text_capacity) list->text_capacity *= 2;
+        list->text = realloc(list->text, list->text_capacity);
+        if (!list->text)
+        {
+            printf_error_exit(ERR_NO_MEMORY, "Not enough memory.");
+        }
+    }
+
+    const size_t start = list->text_size;
+    memcpy(&list->text[start], text, size);
+    list->text[start + size] = '\0';
+    list->text_size += size + 1;
+    return start;
+}
+
+// Allocate the memory for an empty list of draw commands
+void render_init(RenderList *list)
+{
+    *list = (RenderList){0};
+    list->capacity = 16;
+    list->commands = xmalloc(sizeof(typeof(*list->commands)) * list->capacity);
+    list->text_capacity = 64;
+    list->text = xmalloc(list->text_capacity);
+}
+
+// Draw a cell at the given position
+void render_cell(RenderList *list, GameCoord pos, ScreenCell cell)
+{
+    RenderCommand *command = render_push(list, RENDER_CELL);
+    command->pos = pos;
+    command->cell = cell;
+}
+
+// Draw a string of ASCII characters, starting from the given position
+// Returns the coordinate right after the last character.
+// Note: the position is on the terminal, even when the board cells are packed (see packed_screen.h).
+GameCoord render_text(RenderList *list, GameCoord pos, const char *text, CellColor color)
+{
+    const size_t size = strlen(text);
+    const uint32_t start = render_push_text(list, text, size);
+
+    RenderCommand *command = render_push(list, RENDER_TEXT);
+    command->pos = pos;
+    command->cell.color = color;
+    command->text_start = start;
+    command->text_size = size;
+
+    pos.col += size;
+    return pos;
+}
+
+// Make a notification sound
+void render_bell(RenderList *list)
+{
+    render_push(list, RENDER_BELL);
+}
+
+// Pass the commands to a backend, then empty the list
+// 'wait' tells the backend that the commands should be completely output before returning.
+void render_submit(RenderList *list, const RenderBackend *backend, bool wait)
+{
+    backend->submit(backend->context, list, wait);
+    render_clear(list);
+}
+
+// Remove all commands from the list
+void render_clear(RenderList *list)
+{
+    list->count = 0;
+    list->text_size = 0;
+}
+
+// Free the memory used by a list of draw commands
+void render_free(RenderList *list)
+{
+    free(list->commands);
+    free(list->text);
+    *list = (RenderList){0};
+}
+
+/* Backends */
+
+// Draw the commands to a screen buffer, then flush it to the terminal
+static void screen_submit(void *context, const RenderList *list, bool wait)
+{
+    ScreenBuffer *screen = context;
+
+    for (size_t i = 0; i < list->count; i++)
+    {
+        const RenderCommand *command = &list->commands[i];
+        switch (command->type)
+        {
+            case RENDER_CELL:
+                screen_set(screen, command->pos, command->cell);
+                break;
+
+            case RENDER_TEXT:
+                screen_text(screen, command->pos, &list->text[command->text_start], command->cell.color);
+                break;
+
+            case RENDER_BELL:
+                screen_write(screen, "\a", 1);
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    // If the terminal is lagging behind and 'wait' is not set, the changes are merged into the next flush
+    screen_flush(screen, wait);
+}
+
+// Draw the commands to a region of a screen buffer
+static void viewport_submit(void *context, const RenderList *list, bool wait)
+{
+    (void)wait;     // The screen is flushed once for all viewports, by whoever owns the screen
+    const RenderViewport *viewport = context;
+    ScreenBuffer *screen = viewport->screen;
+    const GameCoord offset = {viewport->origin.row - 1, viewport->origin.col - 1};
+
+    for (size_t i = 0; i < list->count; i++)
+    {
+        const RenderCommand *command = &list->commands[i];
+        if (command->type == RENDER_BELL)
+        {
+            screen_write(screen, "\a", 1);
+            continue;
+        }
+
+        // Skip what starts outside of the region
+        GameCoord pos = command->pos;
+        if (pos.row < 1 || pos.row > viewport->size.row || pos.col < 1) continue;
+
+        switch (command->type)
+        {
+            case RENDER_CELL:
+                if (pos.col > viewport->size.col) break;
+                screen_set(screen, (GameCoord){pos.row + offset.row, pos.col + offset.col}, command->cell);
+                break;
+
+            case RENDER_TEXT:
+            {
+                // The characters past the region's right border are not drawn
+                ScreenCell cell = CELL_INIT(" ", command->cell.color);
+                const char *text = &list->text[command->text_start];
+                for (; *text && pos.col <= viewport->size.col; text++, pos.col++)
+                {
+                    cell.glyph[0] = *text;
+                    screen_set(screen, (GameCoord){pos.row + offset.row, pos.col + offset.col}, cell);
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+}
+
+// Discard the commands
+static void null_submit(void *context, const RenderList *list, bool wait)
+{
+    (void)context;
+    (void)list;
+    (void)wait;
+}
+
+// Backend that draws the commands to a screen buffer, then flushes it to the terminal
+RenderBackend render_backend_screen(ScreenBuffer *screen)
+{
+    return (RenderBackend){.submit = &screen_submit, .context = screen};
+}
+
+// Backend that draws the commands to a region of a screen buffer, without flushing it
+// The commands' coordinates are relative to the region, so (1,1) is drawn at the region's origin.
+// Several viewports can draw to the same screen, then it is flushed once for all of them.
+RenderBackend render_backend_viewport(RenderViewport *viewport)
+{
+    return (RenderBackend){.submit = &viewport_submit, .context = viewport};
+}
+
+// Backend that discards the commands
+RenderBackend render_backend_null()
+{
+    return (RenderBackend){.submit = &null_submit, .context = NULL};
+}
@@ -0,0 +1,79 @@
+// Draw commands that the game logic appends on each tick, then submits to a backend
+
+#pragma once
+
+#include "includes.h"
+
+// Kinds of draw commands
+typedef enum RenderCommandType {RENDER_CELL=0, RENDER_TEXT, RENDER_BELL} RenderCommandType;
+
+// A single draw command
+typedef struct RenderCommand
+{
+    uint8_t type;           // What the command does (a value of RenderCommandType)
+    GameCoord pos;          // (RENDER_CELL and RENDER_TEXT) Where to draw
+    ScreenCell cell;        // (RENDER_CELL) What to draw; (RENDER_TEXT) only its .color is used
+    uint32_t text_start;    // (RENDER_TEXT) Position on the list's .text[] where the string starts
+    uint32_t text_size;     // (RENDER_TEXT) Amount of characters of the string
+} RenderCommand;
+
+// Draw commands of a game tick
+typedef struct RenderList
+{
+    RenderCommand *commands;    // (dynamic array) Commands in the order they were added
+    size_t count;               // Amount of elements on .commands[]
+    size_t capacity;            // Maximum amount of elements that .commands[] can hold before being resized
+    char *text;                 // (dynamic array) NUL terminated strings of the text commands
+    size_t text_size;           // Amount of bytes on .text[]
+    size_t text_capacity;       // Maximum amount of bytes that .text[] can hold before being resized
+} RenderList;
+
+// Receiver of the draw commands
+typedef struct RenderBackend
+{
+    void (*submit)(void *context, const RenderList *list, bool wait);   // Function that consumes the commands of a tick
+    void *context;  // Pointer passed as the first argument of .submit()
+} RenderBackend;
+
+// Region of a screen where a backend draws to (see render_backend_viewport())
+typedef struct RenderViewport
+{
+    ScreenBuffer *screen;   // Screen where the commands are drawn to
+    GameCoord origin;       // Top left corner of the region on the screen
+    GameCoord size;         // Amount of rows and columns of the region (what is drawn outside of it is ignored)
+} RenderViewport;
+
+// Allocate the memory for an empty list of draw commands
+void render_init(RenderList *list);
+
+// Draw a cell at the given position
+void render_cell(RenderList *list, GameCoord pos, ScreenCell cell);
+
+// Draw a string of ASCII characters, starting from the given position
+// Returns the coordinate right after the last character.
+// Note: the position is on the terminal, even when the board cells are packed (see packed_screen.h).
+GameCoord render_text(RenderList *list, GameCoord pos, const char *text, CellColor color);
+
+// Make a notification sound
+void render_bell(RenderList *list);
+
+// Pass the commands to a backend, then empty the list
+// 'wait' tells the backend that the commands should be completely output before returning.
+void render_submit(RenderList *list, const RenderBackend *backend, bool wait);
+
+// Remove all commands from the list
+void render_clear(RenderList *list);
+
+// Free the memory used by a list of draw commands
+void render_free(RenderList *list);
+
+// Backend that draws the commands to a screen buffer, then flushes it to the terminal
+RenderBackend render_backend_screen(ScreenBuffer *screen);
+
+// Backend that draws the commands to a region of a screen buffer, without flushing it
+// The commands' coordinates are relative to the region, so (1,1) is drawn at the region's origin.
+// Several viewports can draw to the same screen, then it is flushed once for all of them.
+RenderBackend render_backend_viewport(RenderViewport *viewport);
+
+// Backend that discards the commands
+RenderBackend render_backend_null();
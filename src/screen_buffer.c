@@ -0,0 +1,635 @@
+#include "includes.h"
+
+// Escape sequence and its size in bytes
+typedef struct EscapeSeq
+{
+    const char *bytes;
+    size_t size;
+} EscapeSeq;
+
+#define ESCAPE_SEQ(literal) {(literal), sizeof(literal) - 1}
+
+// Escape sequences for each value of CellColor
+static const EscapeSeq cell_color_seq[] = {
+    [CELL_GRAY] = ESCAPE_SEQ(TEXT_GRAY),
+    [CELL_GREEN] = ESCAPE_SEQ(TEXT_GREEN),
+    [CELL_RED] = ESCAPE_SEQ(TEXT_RED),
+    [CELL_YELLOW] = ESCAPE_SEQ(TEXT_YELLOW),
+    [CELL_CYAN] = ESCAPE_SEQ(TEXT_CYAN),
+    [CELL_WHITE] = ESCAPE_SEQ(TEXT_WHITE),
+};
+
+// Character that replaces an UTF-8 character when using DEC Special Graphics
+typedef struct DecGlyph
+{
+    char utf8[4];   // Original character
+    char byte;      // Replacement character
+} DecGlyph;
+
+// Line drawing characters, and their equivalents on the DEC Special Graphics set
+// (it has no double lines, so the snake's body also uses single lines)
+static const DecGlyph dec_line_glyphs[] = {
+    {u8"┌", 'l'}, {u8"┐", 'k'}, {u8"└", 'm'}, {u8"┘", 'j'}, {u8"─", 'q'}, {u8"│", 'x'},
+    {u8"╔", 'l'}, {u8"╗", 'k'}, {u8"╚", 'm'}, {u8"╝", 'j'}, {u8"═", 'q'}, {u8"║", 'x'},
+};
+
+// Characters that are not on the DEC Special Graphics set, and their ASCII replacements
+// (the block characters are the ones of the packed board modes, see packed_screen.h)
+static const DecGlyph dec_ascii_glyphs[] = {
+    {u8"▲", '^'}, {u8"▼", 'v'}, {u8"◄", '<'}, {u8"►", '>'},
+    {u8"▘", '\''}, {u8"▝", '\''}, {u8"▀", '"'}, {u8"▖", '.'}, {u8"▌", '['}, {u8"▞", '/'}, {u8"▛", 'F'},
+    {u8"▗", '.'}, {u8"▚", '\\'}, {u8"▐", ']'}, {u8"▜", '7'}, {u8"▄", '_'}, {u8"▙", 'L'}, {u8"▟", 'J'}, {u8"█", '#'},
+};
+
+// Amount of decimal digits of an unsigned integer
+static inline size_t count_digits(size_t value)
+{
+    size_t count = 1;
+    while (value >= 10)
+    {
+        value /= 10;
+        count++;
+    }
+    return count;
+}
+
+// Amount of bytes of a relative cursor movement sequence (like CSI n A) that moves by the given amount
+// Note: the amount is omitted from the sequence when it is 1.
+static inline size_t relative_move_cost(size_t amount)
+{
+    if (amount == 0) return 0;
+    return (amount == 1) ? 3 : 3 + count_digits(amount);
+}
+
+// Comparison function for sorting the indices of the changed cells
+static int compare_index(const void *a, const void *b)
+{
+    const uint32_t index_a = *(const uint32_t*)a;
+    const uint32_t index_b = *(const uint32_t*)b;
+    return (index_a > index_b) - (index_a < index_b);
+}
+
+// Add a cell to the list of changed cells, if it is not already there
+static void mark_dirty(ScreenBuffer *screen, size_t index)
+{
+    ScreenCell *back = &screen->back[index];
+    if (back->dirty) return;
+
+    if (screen->dirty_count == screen->dirty_capacity)
+    {
+        // Double the capacity of the list when it gets full
+        screen->dirty_capacity *= 2;
+        screen->dirty = realloc(screen->dirty, sizeof(typeof(*screen->dirty)) * screen->dirty_capacity);
+        if (!screen->dirty)
+        {
+            printf_error_exit(ERR_NO_MEMORY, "Not enough memory.");
+        }
+    }
+
+    screen->dirty[screen->dirty_count++] = index;
+    back->dirty = true;
+}
+
+// Whether two cells have the same contents
+static inline bool same_cell(const ScreenCell *a, const ScreenCell *b)
+{
+    return a->size == b->size && a->color == b->color && memcmp(a->glyph, b->glyph, a->size) == 0;
+}
+
+// Append the sequence that changes the text color, if the terminal is not already on that color
+// Returns whether the sequence was appended.
+static inline bool append_color(OutputBuffer *out, int *current, uint8_t color)
+{
+    if (*current == color) return false;
+
+    const EscapeSeq seq = cell_color_seq[color];
+    output_append(out, seq.bytes, seq.size);
+    *current = color;
+    return true;
+}
+
+// Convert in-place a cell's character to a single byte, for outputting it when DEC Special Graphics is in use
+// Returns the character set that the cell needs (0 for G0, 1 for G1), or -1 if it looks the same on both.
+// Note: the DEC Special Graphics set only replaces the characters from 0x5F to 0x7E (mostly the lowercase letters),
+//       so for example the blank spaces, digits, and uppercase letters do not need to switch the character set.
+static int dec_translate(ScreenCell *cell)
+{
+    if (cell->size > 1)
+    {
+        for (size_t i = 0; i < sizeof(dec_line_glyphs) / sizeof(*dec_line_glyphs); i++)
+        {
+            if (memcmp(cell->glyph, dec_line_glyphs[i].utf8, cell->size) != 0) continue;
+            cell->glyph[0] = dec_line_glyphs[i].byte;
+            cell->size = 1;
+            return 1;
+        }
+
+        for (size_t i = 0; i < sizeof(dec_ascii_glyphs) / sizeof(*dec_ascii_glyphs); i++)
+        {
+            if (memcmp(cell->glyph, dec_ascii_glyphs[i].utf8, cell->size) != 0) continue;
+            cell->glyph[0] = dec_ascii_glyphs[i].byte;
+            cell->size = 1;
+            break;
+        }
+    }
+
+    if (cell->size > 1) return -1;  // Other UTF-8 characters are output unchanged
+    const unsigned char byte = cell->glyph[0];
+    return (byte >= 0x5F && byte <= 0x7E) ? 0 : -1;
+}
+
+// Append the control character that switches to the given character set, if the terminal is not already on it
+// (nothing is appended if 'charset' is -1)
+static inline void append_charset(OutputBuffer *out, int *current, int charset)
+{
+    if (charset < 0 || *current == charset) return;
+    output_append_byte(out, (charset == 1) ? SHIFT_OUT[0] : SHIFT_IN[0]);
+    *current = charset;
+}
+
+// Append the character of a cell, repeated by the given amount of times, then update the cursor's position
+// If the terminal supports it, the repetitions are made with the REP sequence (when that takes less bytes).
+static void append_glyph(OutputBuffer *out, GameCoord *cursor, size_t cols, const ScreenCell *cell, size_t count, bool has_rep)
+{
+    if (count == 0) return;
+    output_append(out, cell->glyph, cell->size);
+
+    // REP sequence: CSI n b
+    const size_t repeat = count - 1;
+    if (has_rep && repeat > 0 && 3 + count_digits(repeat) < repeat * cell->size)
+    {
+        OUTPUT_LITERAL(out, CSI);
+        output_append_uint(out, repeat);
+        output_append_byte(out, 'b');
+    }
+    else
+    {
+        for (size_t i = 0; i < repeat; i++) output_append(out, cell->glyph, cell->size);
+    }
+
+    // Printing a character moves the cursor to the right.
+    // Except on the last column, where the terminal might or might not wrap to the next line on the next character.
+    if (cursor->col + count <= cols) cursor->col += count;
+    else *cursor = (GameCoord){0, 0};
+}
+
+// Append the escape sequence that moves the cursor from its current position to the given position
+// The cheapest way (in bytes) of getting there is used. Returns the amount of bytes that were appended.
+static size_t append_cursor_move(OutputBuffer *out, GameCoord *cursor, GameCoord pos)
+{
+    const GameCoord cur = *cursor;
+    if (cur.row == pos.row && cur.col == pos.col) return 0;
+    *cursor = pos;
+
+    // Cost of an absolute movement: CSI row;col H
+    // (the column can be omitted if it is 1, and the row can be omitted if both are 1)
+    size_t abs_cost = 3;
+    if (pos.row != 1 || pos.col != 1) abs_cost += count_digits(pos.row);
+    if (pos.col != 1) abs_cost += 1 + count_digits(pos.col);
+
+    // Position of the cursor is not known, so the only option is moving it to absolute coordinates
+    if (cur.row == 0)
+    {
+        goto absolute_move;
+    }
+
+    /* Cost of moving vertically then horizontally, using relative movements */
+
+    // Vertical: CSI n A (up), CSI n B (down), or IND (down by 1)
+    const size_t row_delta = (pos.row > cur.row) ? pos.row - cur.row : cur.row - pos.row;
+    const bool row_ind = (pos.row == cur.row + 1);
+    const size_t row_cost = row_ind ? 2 : relative_move_cost(row_delta);
+
+    // Horizontal: CSI n C (right), CSI n D (left), CR (go to column 1), or BS (left by 1)
+    const size_t col_delta = (pos.col > cur.col) ? pos.col - cur.col : cur.col - pos.col;
+    size_t col_cost = relative_move_cost(col_delta);
+    enum {COL_NONE, COL_RELATIVE, COL_CR, COL_BS} col_method = (col_delta == 0) ? COL_NONE : COL_RELATIVE;
+    if (pos.col == 1 && col_delta > 0)
+    {
+        col_cost = 1;
+        col_method = COL_CR;
+    }
+    else if (pos.col < cur.col && col_delta == 1)
+    {
+        col_cost = 1;
+        col_method = COL_BS;
+    }
+
+    // Going to the start of the next line: CR LF
+    // (CR is included because LF might or might not also return the cursor to column 1, depending on the terminal's settings)
+    if (pos.col == 1 && pos.row == cur.row + 1)
+    {
+        OUTPUT_LITERAL(out, "\r\n");
+        return 2;
+    }
+
+    if (abs_cost <= row_cost + col_cost)
+    {
+        goto absolute_move;
+    }
+
+    if (row_ind)
+    {
+        OUTPUT_LITERAL(out, LINE_DOWN);
+    }
+    else if (row_delta > 0)
+    {
+        OUTPUT_LITERAL(out, CSI);
+        if (row_delta > 1) output_append_uint(out, row_delta);
+        output_append_byte(out, (pos.row < cur.row) ? 'A' : 'B');
+    }
+
+    switch (col_method)
+    {
+        case COL_RELATIVE:
+            OUTPUT_LITERAL(out, CSI);
+            if (col_delta > 1) output_append_uint(out, col_delta);
+            output_append_byte(out, (pos.col > cur.col) ? 'C' : 'D');
+            break;
+
+        case COL_CR:
+            output_append_byte(out, '\r');
+            break;
+        
+        case COL_BS:
+            output_append_byte(out, '\b');
+            break;
+        
+        default:
+            break;
+    }
+
+    return row_cost + col_cost;
+
+    absolute_move:
+    OUTPUT_LITERAL(out, CSI);
+    if (pos.row != 1 || pos.col != 1) output_append_uint(out, pos.row);
+    if (pos.col != 1)
+    {
+        output_append_byte(out, ';');
+        output_append_uint(out, pos.col);
+    }
+    output_append_byte(out, 'H');
+    return abs_cost;
+}
+
+// Create the buffers for a terminal screen of the given size
+// All cells start as a blank space, which is expected to match a freshly cleared terminal screen.
+ScreenBuffer* screen_create(size_t rows, size_t cols)
+{
+    if (rows == 0 || cols == 0)
+    {
+        printf_error_exit(ERR_INVALID_ARGS, "Screen buffer must not have an width or a height of zero.");
+    }
+
+    ScreenBuffer *screen = xmalloc(sizeof(ScreenBuffer));
+    screen->rows = rows;
+    screen->cols = cols;
+
+    const size_t cell_count = rows * cols;
+    screen->front = xmalloc(sizeof(ScreenCell) * cell_count);
+    screen->back = xmalloc(sizeof(ScreenCell) * cell_count);
+
+    const ScreenCell blank = CELL_INIT(" ", CELL_GRAY);
+    for (size_t i = 0; i < cell_count; i++)
+    {
+        screen->front[i] = blank;
+        screen->back[i] = blank;
+    }
+
+    screen->cursor = (GameCoord){0, 0};  // We do not know where the cursor is until we move it
+    screen->color = -1; // Neither which color the text has until we set it
+
+    screen->dirty_capacity = 64;
+    screen->dirty = xmalloc(sizeof(typeof(*screen->dirty)) * screen->dirty_capacity);
+
+    // Start with enough space for drawing the entire screen once
+    output_init(&screen->out, cell_count * 4);
+    output_set_nonblocking(&screen->out);
+
+    // The static layer starts empty
+    output_init(&screen->static_layer, 256);
+    screen->static_capacity = 16;
+    screen->static_runs = xmalloc(sizeof(typeof(*screen->static_runs)) * screen->static_capacity);
+    screen->static_cursor = (GameCoord){0, 0};
+    screen->static_color = -1;
+    screen->static_charset = -1;
+    screen->charset = -1;
+
+    return screen;
+}
+
+// Write a cell to the given position of the back buffer
+// Note: coordinates outside of the screen are ignored.
+void screen_set(ScreenBuffer *screen, GameCoord pos, ScreenCell cell)
+{
+    if (pos.row < 1 || pos.row > screen->rows || pos.col < 1 || pos.col > screen->cols) return;
+
+    const size_t index = (pos.row - 1) * screen->cols + (pos.col - 1);
+    ScreenCell *back = &screen->back[index];
+    const bool is_dirty = back->dirty;
+    *back = cell;
+    back->dirty = is_dirty;
+
+    mark_dirty(screen, index);
+}
+
+// Write a string of ASCII characters to the back buffer, starting from the given position
+// Returns the coordinate right after the last written character.
+GameCoord screen_text(ScreenBuffer *screen, GameCoord pos, const char *text, CellColor color)
+{
+    ScreenCell cell = CELL_INIT(" ", color);
+    while (*text)
+    {
+        cell.glyph[0] = *text++;
+        screen_set(screen, pos, cell);
+        pos.col++;
+    }
+
+    return pos;
+}
+
+// Add a horizontal run of identical cells to the static layer of the screen
+// The cells are written to the back buffer, and they are going to be drawn on the next redraw of the screen.
+// Note: the part of the run outside of the screen is ignored. The run is pre-rendered right away,
+//       so the fields .has_rep and .dec_graphics of the screen should be set before calling this function.
+void screen_static_run(ScreenBuffer *screen, GameCoord pos, ScreenCell cell, size_t count)
+{
+    if (pos.row < 1 || pos.row > screen->rows || pos.col < 1 || pos.col > screen->cols) return;
+    if (count > screen->cols - pos.col + 1) count = screen->cols - pos.col + 1;
+    if (count == 0) return;
+
+    // Write the cells to the back buffer
+    // (they are not added to the list of changed cells, since they are going to be drawn by the static layer)
+    const size_t index = (pos.row - 1) * screen->cols + (pos.col - 1);
+    cell.dirty = false;
+    for (size_t i = 0; i < count; i++)
+    {
+        ScreenCell *back = &screen->back[index + i];
+        const bool is_dirty = back->dirty;
+        *back = cell;
+        back->dirty = is_dirty;
+    }
+
+    // Remember the run, so the front buffer can be updated when the static layer gets drawn
+    if (screen->static_count == screen->static_capacity)
+    {
+        // Double the capacity of the list when it gets full
+        screen->static_capacity *= 2;
+        screen->static_runs = realloc(screen->static_runs, sizeof(typeof(*screen->static_runs)) * screen->static_capacity);
+        if (!screen->static_runs)
+        {
+            printf_error_exit(ERR_NO_MEMORY, "Not enough memory.");
+        }
+    }
+    screen->static_runs[screen->static_count++] = (StaticRun){index, count, cell};
+
+    // Pre-render the run
+    OutputBuffer *layer = &screen->static_layer;
+    append_cursor_move(layer, &screen->static_cursor, pos);
+    append_color(layer, &screen->static_color, cell.color);
+    if (screen->dec_graphics) append_charset(layer, &screen->static_charset, dec_translate(&cell));
+    append_glyph(layer, &screen->static_cursor, screen->cols, &cell, count, screen->has_rep);
+}
+
+// Add to the static layer a rectangle with the given top left and bottom right corners
+void screen_static_box(ScreenBuffer *screen, GameCoord top_left, GameCoord bottom_right, CellColor color)
+{
+    if (bottom_right.row <= top_left.row || bottom_right.col <= top_left.col) return;
+    const size_t inner_width = bottom_right.col - top_left.col - 1;
+
+    // Top border
+    screen_static_run(screen, top_left, CELL(BOX_TOP_LEFT, color), 1);
+    screen_static_run(screen, (GameCoord){top_left.row, top_left.col + 1}, CELL(BOX_HORIZONTAL, color), inner_width);
+    screen_static_run(screen, (GameCoord){top_left.row, bottom_right.col}, CELL(BOX_TOP_RIGHT, color), 1);
+
+    // Laterals
+    // (each one is drawn from top to bottom, so the cursor only needs to go down by one row and back by one column each time)
+    for (size_t row = top_left.row + 1; row < bottom_right.row; row++)
+    {
+        screen_static_run(screen, (GameCoord){row, top_left.col}, CELL(BOX_VERTICAL, color), 1);
+    }
+    for (size_t row = top_left.row + 1; row < bottom_right.row; row++)
+    {
+        screen_static_run(screen, (GameCoord){row, bottom_right.col}, CELL(BOX_VERTICAL, color), 1);
+    }
+
+    // Bottom border
+    screen_static_run(screen, (GameCoord){bottom_right.row, top_left.col}, CELL(BOX_BOTTOM_LEFT, color), 1);
+    screen_static_run(screen, (GameCoord){bottom_right.row, top_left.col + 1}, CELL(BOX_HORIZONTAL, color), inner_width);
+    screen_static_run(screen, bottom_right, CELL(BOX_BOTTOM_RIGHT, color), 1);
+}
+
+// Add to the static layer a string of ASCII characters, starting from the given position
+// Returns the coordinate right after the last written character.
+GameCoord screen_static_text(ScreenBuffer *screen, GameCoord pos, const char *text, CellColor color)
+{
+    ScreenCell cell = CELL_INIT(" ", color);
+    while (*text)
+    {
+        // Group the repeated characters into a single run
+        size_t count = 1;
+        while (text[count] == text[0]) count++;
+
+        cell.glyph[0] = *text;
+        screen_static_run(screen, pos, cell, count);
+        pos.col += count;
+        text += count;
+    }
+
+    return pos;
+}
+
+// Append to the output the escape sequence that moves the cursor to the given position
+// The cheapest way (in bytes) of getting there from the current cursor's position is used.
+// Returns the amount of bytes that were appended.
+size_t screen_move_cursor(ScreenBuffer *screen, GameCoord pos)
+{
+    return append_cursor_move(&screen->out, &screen->cursor, pos);
+}
+
+// Append raw bytes to the output (for sequences that are not part of a cell, like the terminal's bell)
+// Note: the bytes should not move the cursor or change the text color.
+void screen_write(ScreenBuffer *screen, const char *bytes, size_t size)
+{
+    output_append(&screen->out, bytes, size);
+}
+
+// Write to the terminal the cells that changed since the last flush
+// Note: all the output of the frame is written at once.
+// If the terminal has not yet consumed the previous frames, the frame is skipped and 'false' is returned.
+// The skipped changes are going to be drawn along with the next frame. This function does not wait for the terminal,
+// unless 'force' is passed, which prevents the frame from being skipped and waits until all of it is written.
+bool screen_flush(ScreenBuffer *screen, bool force)
+{
+    OutputBuffer *out = &screen->out;
+    uint64_t cells = 0;
+    uint64_t sgr_suppressed = 0;
+
+    // Skip the frame if the terminal is lagging behind, so we do not get blocked waiting for it to consume the output.
+    // The changed cells remain on the list, so the changes of several frames are merged into a single one.
+    if (!force && output_lagging(out))
+    {
+        output_flush(out, false);   // Keep sending the remaining bytes of the previous frames
+
+        // After MAX_SKIPPED_FRAMES in a row, the frame is drawn once the bytes of the previous frames were all written
+        // (the frame is never appended to unwritten bytes, so they can not pile up when the terminal is too slow)
+        if (screen->skipped_count < MAX_SKIPPED_FRAMES || out->backlog > 0)
+        {
+            screen->skipped_count++;
+            screen->total_skipped++;
+            return false;
+        }
+    }
+    screen->skipped_count = 0;
+
+    // Begin a synchronized update, so the terminal displays the entire frame at once
+    const size_t frame_start = out->size;
+    if (screen->sync_output) OUTPUT_LITERAL(out, SYNC_BEGIN);
+
+    // Erase the screen and draw the static layer, if a redraw was requested
+    if (screen->redraw_pending)
+    {
+        OUTPUT_LITERAL(out, BG_BLACK CLEAR_SCREEN);
+        if (screen->dec_graphics) OUTPUT_LITERAL(out, CHARSET_G1_DEC);
+        output_append(out, screen->static_layer.data, screen->static_layer.size);
+        screen->cursor = screen->static_cursor;
+        screen->color = screen->static_color;
+        screen->charset = screen->static_charset;
+        screen->redraw_pending = false;
+    }
+
+    // Output the cells in the order they appear on the screen,
+    // so the cursor often only needs to move a short distance to the next cell
+    qsort(screen->dirty, screen->dirty_count, sizeof(typeof(*screen->dirty)), &compare_index);
+
+    for (size_t i = 0; i < screen->dirty_count; i++)
+    {
+        const size_t index = screen->dirty[i];
+        ScreenCell *back = &screen->back[index];
+        ScreenCell *front = &screen->front[index];
+        back->dirty = false;
+
+        // Skip the cells that ended up with the same contents that are already on the terminal
+        if (same_cell(back, front)) continue;
+
+        // Move the cursor to the cell
+        const GameCoord pos = {(index / screen->cols) + 1, (index % screen->cols) + 1};
+        screen_move_cursor(screen, pos);
+
+        // Change the text color, if the terminal is not already on the cell's color
+        if (!append_color(out, &screen->color, back->color)) sgr_suppressed++;
+
+        // Print the cell's contents
+        // (switching the character set if needed, when the lines are drawn with DEC Special Graphics)
+        ScreenCell glyph = *back;
+        if (screen->dec_graphics) append_charset(out, &screen->charset, dec_translate(&glyph));
+        append_glyph(out, &screen->cursor, screen->cols, &glyph, 1, false);
+        cells++;
+
+        *front = *back;
+    }
+
+    screen->dirty_count = 0;
+
+    // End the synchronized update
+    // (or remove its beginning, if there was nothing to be drawn)
+    if (screen->sync_output)
+    {
+        if (out->size == frame_start + sizeof(SYNC_BEGIN) - 1) out->size = frame_start;
+        else OUTPUT_LITERAL(out, SYNC_END);
+    }
+
+    output_flush(out, force);
+
+    // Update the output statistics
+    screen->frame_cells = cells;
+    screen->frame_sgr_suppressed = sgr_suppressed;
+    screen->total_sgr_suppressed += sgr_suppressed;
+    screen->total_frames++;
+
+    return true;
+}
+
+// Erase the terminal screen, then draw all cells on the next flush
+// The static layer is output as it was pre-rendered, and then only the other cells that are not blank get drawn.
+void screen_redraw(ScreenBuffer *screen)
+{
+    const size_t cell_count = screen->rows * screen->cols;
+
+    // After the redraw starts, the terminal is going to show a blank screen with the static layer over it
+    const ScreenCell blank = CELL_INIT(" ", CELL_GRAY);
+    for (size_t i = 0; i < cell_count; i++) screen->front[i] = blank;
+
+    for (size_t i = 0; i < screen->static_count; i++)
+    {
+        const StaticRun run = screen->static_runs[i];
+        for (size_t j = 0; j < run.count; j++) screen->front[run.index + j] = run.cell;
+    }
+
+    // Every cell that is different from that needs to be drawn
+    for (size_t i = 0; i < cell_count; i++)
+    {
+        if (!same_cell(&screen->back[i], &screen->front[i])) mark_dirty(screen, i);
+    }
+
+    screen->redraw_pending = true;
+}
+
+// Change the size of the screen, erasing all cells and the static layer
+// The terminal screen is erased on the next flush, so everything that should be shown on it
+// (including the static layer) needs to be drawn again before that.
+void screen_resize(ScreenBuffer *screen, size_t rows, size_t cols)
+{
+    if (rows == 0 || cols == 0)
+    {
+        printf_error_exit(ERR_INVALID_ARGS, "Screen buffer must not have an width or a height of zero.");
+    }
+
+    const size_t cell_count = rows * cols;
+    if (cell_count > screen->rows * screen->cols)
+    {
+        free(screen->front);
+        free(screen->back);
+        screen->front = xmalloc(sizeof(ScreenCell) * cell_count);
+        screen->back = xmalloc(sizeof(ScreenCell) * cell_count);
+        output_reserve(&screen->out, cell_count * 4);
+    }
+
+    screen->rows = rows;
+    screen->cols = cols;
+
+    const ScreenCell blank = CELL_INIT(" ", CELL_GRAY);
+    for (size_t i = 0; i < cell_count; i++)
+    {
+        screen->front[i] = blank;
+        screen->back[i] = blank;
+    }
+    screen->dirty_count = 0;
+
+    // The static layer starts empty again
+    screen->static_layer.size = 0;
+    screen->static_count = 0;
+    screen->static_cursor = (GameCoord){0, 0};
+    screen->static_color = -1;
+    screen->static_charset = -1;
+
+    // The terminal may have moved the cursor while resizing
+    screen->cursor = (GameCoord){0, 0};
+    screen->color = -1;
+    screen->charset = -1;
+    screen->redraw_pending = true;
+}
+
+// Free the memory used by the screen buffers
+void screen_destroy(ScreenBuffer *screen)
+{
+    if (!screen) return;
+    free(screen->front);
+    free(screen->back);
+    free(screen->dirty);
+    free(screen->static_runs);
+    output_free(&screen->out);
+    output_free(&screen->static_layer);
+    free(screen);
+}
@@ -0,0 +1,132 @@
+// Retained grid of the terminal's cells, of which only the changed cells are output once per frame
+
+#pragma once
+
+#include "includes.h"
+
+#define MAX_SKIPPED_FRAMES 8    // Frames in a row that are skipped when the terminal is lagging behind, before drawing one anyway
+
+// Colors that a cell of the screen can have
+typedef enum CellColor {CELL_GRAY=0, CELL_GREEN, CELL_RED, CELL_YELLOW, CELL_CYAN, CELL_WHITE} CellColor;
+
+// A single character on the terminal screen
+typedef struct ScreenCell
+{
+    char glyph[4];  // Character encoded in UTF-8 (not NUL terminated)
+    uint8_t size;   // Amount of bytes on .glyph[]
+    uint8_t color;  // Text color of the character (a value of CellColor)
+    bool dirty;     // (back buffer only) Whether the cell is already on the list of changed cells
+} ScreenCell;
+
+// Initializer of a ScreenCell from a string literal and a color
+// The size of the character is calculated at compile time, so it can be used for building constant tables of cells.
+// Note: the literal must be at most 4 bytes long (not counting the NUL terminator), otherwise compilation fails.
+#define CELL_INIT(glyph_literal, cell_color) {\
+    .glyph = glyph_literal,\
+    .size = sizeof(glyph_literal) - 1,\
+    .color = (cell_color),\
+    .dirty = false,\
+}
+
+// ScreenCell value from a string literal and a color
+#define CELL(glyph_literal, cell_color) ((ScreenCell)CELL_INIT(glyph_literal, cell_color))
+
+// Horizontal run of identical cells that belong to the static layer of the screen
+typedef struct StaticRun
+{
+    uint32_t index;     // Position on the buffers of the first cell of the run
+    uint32_t count;     // Amount of cells on the run
+    ScreenCell cell;    // Contents of each cell
+} StaticRun;
+
+// Front and back buffers of the terminal screen
+// Note: the cells are stored row by row, and (row, col) coordinates passed to the functions are 1-indexed.
+typedef struct ScreenBuffer
+{
+    ScreenCell *front;      // What is currently being shown on the terminal
+    ScreenCell *back;       // What should be shown on the terminal after the next flush
+    uint32_t *dirty;        // (dynamic array) Indices of the cells that were written to since the last flush
+    size_t dirty_count;     // Amount of elements on .dirty[]
+    size_t dirty_capacity;  // Maximum amount of elements that .dirty[] can hold before being resized
+    size_t rows;            // Amount of rows on the screen
+    size_t cols;            // Amount of columns on the screen
+    GameCoord cursor;       // Current position of the terminal's cursor (row 0 means that the position is unknown)
+    int color;              // Current text color of the terminal (a value of CellColor, or -1 if unknown)
+    OutputBuffer out;       // Bytes to be written to the terminal at the end of the frame
+    bool sync_output;       // Whether each frame is wrapped in the sequences for synchronized output
+    size_t skipped_count;   // Amount of frames in a row that were skipped because the terminal was lagging behind
+    bool has_rep;           // Whether the terminal supports repeating the previous character (REP sequence)
+    bool dec_graphics;      // Whether the line drawing characters are output with the DEC Special Graphics set
+    int charset;            // Current character set of the terminal (0 for G0, 1 for G1, or -1 if unknown)
+    bool redraw_pending;    // Whether the next flush should erase the terminal screen and draw everything again
+
+    // Static layer: the cells that do not change during the game (like the borders and the labels)
+    // Those cells are pre-rendered once, so a full redraw of the screen only needs to output the same bytes again.
+    OutputBuffer static_layer;  // Pre-rendered bytes that draw all the static cells
+    StaticRun *static_runs;     // (dynamic array) Positions and contents of the static cells
+    size_t static_count;        // Amount of elements on .static_runs[]
+    size_t static_capacity;     // Maximum amount of elements that .static_runs[] can hold before being resized
+    GameCoord static_cursor;    // Position of the cursor after drawing the static layer (row 0 means that the position is unknown)
+    int static_color;           // Text color after drawing the static layer (a value of CellColor, or -1 if unknown)
+    int static_charset;         // Character set after drawing the static layer (0 for G0, 1 for G1, or -1 if unknown)
+
+    // Output statistics
+    uint64_t frame_cells;   // Amount of cells updated on the last flush
+    uint64_t frame_sgr_suppressed;  // Amount of color sequences that were not needed on the last flush
+    uint64_t total_frames;  // Amount of flushes so far
+    uint64_t total_skipped; // Amount of flushes that were skipped because the terminal was lagging behind
+    uint64_t total_sgr_suppressed;  // Amount of color sequences that were not needed on all flushes
+} ScreenBuffer;
+
+// Create the buffers for a terminal screen of the given size
+// All cells start as a blank space, which is expected to match a freshly cleared terminal screen.
+ScreenBuffer* screen_create(size_t rows, size_t cols);
+
+// Write a cell to the given position of the back buffer
+// Note: coordinates outside of the screen are ignored.
+void screen_set(ScreenBuffer *screen, GameCoord pos, ScreenCell cell);
+
+// Write a string of ASCII characters to the back buffer, starting from the given position
+// Returns the coordinate right after the last written character.
+GameCoord screen_text(ScreenBuffer *screen, GameCoord pos, const char *text, CellColor color);
+
+// Add a horizontal run of identical cells to the static layer of the screen
+// The cells are written to the back buffer, and they are going to be drawn on the next redraw of the screen.
+// Note: the part of the run outside of the screen is ignored. The run is pre-rendered right away,
+//       so the fields .has_rep and .dec_graphics of the screen should be set before calling this function.
+void screen_static_run(ScreenBuffer *screen, GameCoord pos, ScreenCell cell, size_t count);
+
+// Add to the static layer a rectangle with the given top left and bottom right corners
+void screen_static_box(ScreenBuffer *screen, GameCoord top_left, GameCoord bottom_right, CellColor color);
+
+// Add to the static layer a string of ASCII characters, starting from the given position
+// Returns the coordinate right after the last written character.
+GameCoord screen_static_text(ScreenBuffer *screen, GameCoord pos, const char *text, CellColor color);
+
+// Append to the output the escape sequence that moves the cursor to the given position
+// The cheapest way (in bytes) of getting there from the current cursor's position is used.
+// Returns the amount of bytes that were appended.
+size_t screen_move_cursor(ScreenBuffer *screen, GameCoord pos);
+
+// Append raw bytes to the output (for sequences that are not part of a cell, like the terminal's bell)
+// Note: the bytes should not move the cursor or change the text color.
+void screen_write(ScreenBuffer *screen, const char *bytes, size_t size);
+
+// Write to the terminal the cells that changed since the last flush
+// Note: all the output of the frame is written at once.
+// If the terminal has not yet consumed the previous frames, the frame is skipped and 'false' is returned.
+// The skipped changes are going to be drawn along with the next frame. This function does not wait for the terminal,
+// unless 'force' is passed, which prevents the frame from being skipped and waits until all of it is written.
+bool screen_flush(ScreenBuffer *screen, bool force);
+
+// Erase the terminal screen, then draw all cells on the next flush
+// The static layer is output as it was pre-rendered, and then only the other cells that are not blank get drawn.
+void screen_redraw(ScreenBuffer *screen);
+
+// Change the size of the screen, erasing all cells and the static layer
+// The terminal screen is erased on the next flush, so everything that should be shown on it
+// (including the static layer) needs to be drawn again before that.
+void screen_resize(ScreenBuffer *screen, size_t rows, size_t cols);
+
+// Free the memory used by the screen buffers
+void screen_destroy(ScreenBuffer *screen);
@@ -1,5 +1,53 @@
 #pragma once
 
+/*
+    The characters used for drawing the game are chosen at compile time.
+    By default they are Unicode box drawing characters. Defining the macro SNAKE_ASCII_GLYPHS
+    (for example, by passing -DSNAKE_ASCII_GLYPHS to the compiler) makes the game use only ASCII characters,
+    for terminals or fonts without good Unicode support.
+
+    Note: each character must be at most 4 bytes long when encoded in UTF-8.
+*/
+
+#ifdef SNAKE_ASCII_GLYPHS
+
+#define BOX_TOP_LEFT "+"
+#define BOX_TOP_RIGHT "+"
+#define BOX_BOTTOM_LEFT "+"
+#define BOX_BOTTOM_RIGHT "+"
+#define BOX_HORIZONTAL "-"
+#define BOX_VERTICAL "|"
+
+#define SNAKE_TOP_LEFT "+"
+#define SNAKE_TOP_RIGHT "+"
+#define SNAKE_BOTTOM_LEFT "+"
+#define SNAKE_BOTTOM_RIGHT "+"
+#define SNAKE_HORIZONTAL "="
+#define SNAKE_VERTICAL "H"
+
+#define SNAKE_HEAD_UP "^"
+#define SNAKE_HEAD_DOWN "v"
+#define SNAKE_HEAD_LEFT "<"
+#define SNAKE_HEAD_RIGHT ">"
+
+#define BLOCK_TOP_LEFT "'"
+#define BLOCK_TOP_RIGHT "'"
+#define BLOCK_TOP "\""
+#define BLOCK_BOTTOM_LEFT "."
+#define BLOCK_LEFT "["
+#define BLOCK_DIAGONAL_UP "/"
+#define BLOCK_NOT_BOTTOM_RIGHT "F"
+#define BLOCK_BOTTOM_RIGHT "."
+#define BLOCK_DIAGONAL_DOWN "\\"
+#define BLOCK_RIGHT "]"
+#define BLOCK_NOT_BOTTOM_LEFT "7"
+#define BLOCK_BOTTOM "_"
+#define BLOCK_NOT_TOP_RIGHT "L"
+#define BLOCK_NOT_TOP_LEFT "J"
+#define BLOCK_FULL "#"
+
+#else
+
 #define BOX_TOP_LEFT u8"┌"
 #define BOX_TOP_RIGHT u8"┐"
 #define BOX_BOTTOM_LEFT u8"└"
@@ -19,4 +67,25 @@
 #define SNAKE_HEAD_LEFT u8"◄"
 #define SNAKE_HEAD_RIGHT u8"►"
 
+#define BLOCK_TOP_LEFT u8"▘"
+#define BLOCK_TOP_RIGHT u8"▝"
+#define BLOCK_TOP u8"▀"
+#define BLOCK_BOTTOM_LEFT u8"▖"
+#define BLOCK_LEFT u8"▌"
+#define BLOCK_DIAGONAL_UP u8"▞"
+#define BLOCK_NOT_BOTTOM_RIGHT u8"▛"
+#define BLOCK_BOTTOM_RIGHT u8"▗"
+#define BLOCK_DIAGONAL_DOWN u8"▚"
+#define BLOCK_RIGHT u8"▐"
+#define BLOCK_NOT_BOTTOM_LEFT u8"▜"
+#define BLOCK_BOTTOM u8"▄"
+#define BLOCK_NOT_TOP_RIGHT u8"▙"
+#define BLOCK_NOT_TOP_LEFT u8"▟"
+#define BLOCK_FULL u8"█"
+
+#endif // SNAKE_ASCII_GLYPHS
+
+#define HUD_SIZE_LABEL "Size: "   // Text before the snake's size, at the bottom of the screen
+
 #define FOOD_PELLET "*"
+#define SNAKE_UNKNOWN "?"   // Drawn in case of an invalid direction (this should never happen)
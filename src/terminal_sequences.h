@@ -30,6 +30,11 @@ Example:
 #define HIDE_CURSOR CSI "?25l"      // Do not display the text cursor
 #define SHOW_CURSOR CSI "?25h"      // Display the text cursor
 #define GET_CURSOR_POS CSI "6n"     // Report the cursor's coordinates to stdin (Format: ESC[<row>;<column>R)
+#define LINE_DOWN ESC "D"           // Move the text cursor one row down, keeping it on the same column (IND)
+
+// Print the previous character again for a given amount of times (REP)
+// Note: not all terminals support this sequence, some of them just ignore it.
+#define REPEAT_CHAR(count) CSI #count"b"
 
 // Text and background colors
 // More color values at: https://learn.microsoft.com/en-us/windows/console/console-virtual-terminal-sequences#text-formatting
@@ -42,10 +47,34 @@ Example:
 #define TEXT_WHITE CSI "97m"
 #define BG_BLACK CSI "40m"
 
+// Character sets
+// The line drawing characters of the DEC Special Graphics set take a single byte each. We designate that set as G1,
+// so switching between it and the ASCII characters (on G0) takes a single control character.
+#define CHARSET_G1_DEC ESC ")0"     // Designate DEC Special Graphics as the G1 character set
+#define SHIFT_OUT "\x0e"            // Switch to the G1 character set
+#define SHIFT_IN "\x0f"             // Switch back to the G0 character set (the default)
+
 // Application mode
 #define KP_APP_MODE ESC "="     // Enable Keypad Application Mode
 #define CK_APP_MODE CSI "?1h"   // Enable Cursor Keys Application Mode
 
+// Synchronized output (DEC private mode 2026)
+// The terminal holds the screen's contents between the begin and the end sequences, then displays all changes at once.
+// Terminals that do not support this mode just ignore these sequences.
+#define SYNC_BEGIN CSI "?2026h"
+#define SYNC_END CSI "?2026l"
+
+// Focus reporting (DEC private mode 1004)
+// The terminal sends a sequence to stdin whenever its window gains or loses focus.
+#define FOCUS_REPORT_ON CSI "?1004h"
+#define FOCUS_REPORT_OFF CSI "?1004l"
+#define FOCUS_IN_FINAL 'I'      // Final character of the report when the window gains focus (Format: ESC[I)
+#define FOCUS_OUT_FINAL 'O'     // Final character of the report when the window loses focus (Format: ESC[O)
+
+// Queries about the terminal's features (the replies are sent to stdin)
+#define QUERY_SYNC_OUTPUT CSI "?2026$p"     // Whether synchronized output is supported (Format: ESC[?2026;<value>$y)
+#define QUERY_ATTRIBUTES CSI "c"    // Primary device attributes (Format: ESC[?<attributes>c)
+
 // Reset certain terminal properties back to the default values
 // (cursor visibility, numeric keypad, cursor keys mode, top and bottom margins, character set,
 //  colors, text formatting, saved cursor state)
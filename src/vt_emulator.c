@@ -0,0 +1,617 @@
+#include "includes.h"
+
+// Characters of the DEC Special Graphics set, for the bytes from 0x60 to 0x7E
+// (the line drawing characters, plus a few symbols)
+static const char *const vt_dec_graphics[] = {
+    u8"◆", u8"▒", u8"␉", u8"␌", u8"␍", u8"␊", u8"°", u8"±",    // 0x60 to 0x67
+    u8"␤", u8"␋", u8"┘", u8"┐", u8"┌", u8"└", u8"┼", u8"⎺",    // 0x68 to 0x6F
+    u8"⎻", u8"─", u8"⎼", u8"⎽", u8"├", u8"┤", u8"┴", u8"┬",    // 0x70 to 0x77
+    u8"│", u8"≤", u8"≥", u8"π", u8"≠", u8"£", u8"·",           // 0x78 to 0x7E
+};
+
+// Erase the cells from 'start' to 'end' (inclusive), as indices on the grid
+static void vt_erase(VtEmulator *vt, size_t start, size_t end)
+{
+    const ScreenCell blank = CELL_INIT(" ", CELL_GRAY);
+    for (size_t i = start; i <= end && i < vt->rows * vt->cols; i++) vt->cells[i] = blank;
+}
+
+// Move the cursor down by one row, scrolling the screen up if it is already on the last row
+static void vt_line_feed(VtEmulator *vt)
+{
+    vt->wrap_pending = false;
+    if (vt->cursor.row < vt->rows)
+    {
+        vt->cursor.row++;
+        return;
+    }
+
+    memmove(vt->cells, &vt->cells[vt->cols], sizeof(ScreenCell) * (vt->rows - 1) * vt->cols);
+    vt_erase(vt, (vt->rows - 1) * vt->cols, vt->rows * vt->cols - 1);
+}
+
+// Move the cursor to the given position, clamped to the screen
+static void vt_move(VtEmulator *vt, long row, long col)
+{
+    if (row < 1) row = 1;
+    if (col < 1) col = 1;
+    if ((size_t)row > vt->rows) row = vt->rows;
+    if ((size_t)col > vt->cols) col = vt->cols;
+    vt->cursor = (GameCoord){row, col};
+    vt->wrap_pending = false;
+}
+
+// Write a character at the cursor's position, then move the cursor to the right
+static void vt_print(VtEmulator *vt, const ScreenCell *cell)
+{
+    // The previous character was printed on the last column, so this one goes to the start of the next line
+    if (vt->wrap_pending)
+    {
+        vt->cursor.col = 1;
+        vt_line_feed(vt);
+    }
+
+    vt->cells[(vt->cursor.row - 1) * vt->cols + (vt->cursor.col - 1)] = *cell;
+    vt->last_char = *cell;
+
+    if (vt->cursor.col < vt->cols) vt->cursor.col++;
+    else vt->wrap_pending = true;
+}
+
+// Process a character that has been completely received (its bytes are on .utf8[])
+static void vt_print_utf8(VtEmulator *vt)
+{
+    ScreenCell cell = {.size = vt->utf8_size, .color = vt->color};
+    memcpy(cell.glyph, vt->utf8, vt->utf8_size);
+
+    // Translate the character if the DEC Special Graphics set is in use
+    const unsigned char byte = vt->utf8[0];
+    if (vt->utf8_size == 1 && vt->charset_dec[vt->shift_out] && byte >= 0x60 && byte <= 0x7E)
+    {
+        const char *glyph = vt_dec_graphics[byte - 0x60];
+        cell.size = strlen(glyph);
+        memcpy(cell.glyph, glyph, cell.size);
+    }
+
+    vt_print(vt, &cell);
+}
+
+// Get the numeric parameters of the current control sequence
+// Empty parameters are stored as zero, and the values bigger than VT_PARAM_MAX are clamped to it.
+// Returns the amount of parameters.
+static size_t vt_get_params(const VtEmulator *vt, long *values, size_t max_count)
+{
+    size_t count = 0;
+    long value = 0;
+    bool has_digits = false;
+
+    for (size_t i = 0; i < vt->params_size; i++)
+    {
+        const char c = vt->params[i];
+        if (isdigit((unsigned char)c))
+        {
+            value = value * 10 + (c - '0');
+            if (value > VT_PARAM_MAX) value = VT_PARAM_MAX;
+            has_digits = true;
+        }
+        else if (c == ';')
+        {
+            if (count < max_count) values[count++] = value;
+            value = 0;
+            has_digits = true;
+        }
+    }
+
+    if (has_digits && count < max_count) values[count++] = value;
+    return count;
+}
+
+// Change the text color according to a SGR parameter
+static void vt_set_color(VtEmulator *vt, long value)
+{
+    switch (value)
+    {
+        case 0:     // Reset to the default
+        case 39:
+        case 37:
+            vt->color = CELL_GRAY;
+            break;
+
+        case 92:
+            vt->color = CELL_GREEN;
+            break;
+
+        case 91:
+            vt->color = CELL_RED;
+            break;
+
+        case 93:
+            vt->color = CELL_YELLOW;
+            break;
+
+        case 96:
+            vt->color = CELL_CYAN;
+            break;
+
+        case 97:
+            vt->color = CELL_WHITE;
+            break;
+
+        default:    // Background colors and text formatting do not change the cells
+            break;
+    }
+}
+
+// Execute the control sequence that ended with the given byte
+static void vt_dispatch_csi(VtEmulator *vt, char final)
+{
+    long p[16] = {0};
+    const size_t count = vt_get_params(vt, p, sizeof(p) / sizeof(*p));
+    const long n = (p[0] > 0) ? p[0] : 1;   // Amount for movements (a missing or zero amount means 1)
+    const char prefix = (vt->params_size > 0) ? vt->params[0] : '\0';
+    const char intermediate = (vt->params_size > 0) ? vt->params[vt->params_size - 1] : '\0';
+    const GameCoord cur = vt->cursor;
+    const size_t index = (cur.row - 1) * vt->cols + (cur.col - 1);
+
+    // DEC private modes: CSI ? <mode> h (set) or CSI ? <mode> l (reset)
+    if (prefix == '?' && (final == 'h' || final == 'l'))
+    {
+        const bool is_set = (final == 'h');
+        for (size_t i = 0; i < count; i++)
+        {
+            switch (p[i])
+            {
+                case 1049:  // Alternate screen (the main screen's contents are not kept)
+                    if (is_set == vt->alt_screen) break;
+                    if (is_set) vt->saved_cursor = vt->cursor;
+                    vt_erase(vt, 0, vt->rows * vt->cols - 1);
+                    if (!is_set) vt_move(vt, vt->saved_cursor.row, vt->saved_cursor.col);
+                    vt->alt_screen = is_set;
+                    break;
+
+                case 25:
+                    vt->cursor_visible = is_set;
+                    break;
+
+                case 2026:
+                    vt->sync_output = is_set;
+                    break;
+
+                default:    // Modes that do not change the screen
+                    break;
+            }
+        }
+        return;
+    }
+
+    // Queries and replies do not change the screen
+    if (prefix == '?' || prefix == '>' || intermediate == '$')
+    {
+        return;
+    }
+
+    // Soft reset: CSI ! p
+    if (intermediate == '!' && final == 'p')
+    {
+        vt->color = CELL_GRAY;
+        vt->cursor_visible = true;
+        vt->charset_dec[0] = vt->charset_dec[1] = false;
+        vt->shift_out = false;
+        return;
+    }
+
+    switch (final)
+    {
+        case 'H':   // Cursor position
+        case 'f':
+            vt_move(vt, p[0], (count > 1) ? p[1] : 1);
+            break;
+
+        case 'A':   // Cursor up
+            vt_move(vt, (long)cur.row - n, cur.col);
+            break;
+
+        case 'B':   // Cursor down
+            vt_move(vt, (long)cur.row + n, cur.col);
+            break;
+
+        case 'C':   // Cursor forward
+            vt_move(vt, cur.row, (long)cur.col + n);
+            break;
+
+        case 'D':   // Cursor backward
+            vt_move(vt, cur.row, (long)cur.col - n);
+            break;
+
+        case 'G':   // Cursor to column
+            vt_move(vt, cur.row, n);
+            break;
+
+        case 'd':   // Cursor to row
+            vt_move(vt, n, cur.col);
+            break;
+
+        case 'J':   // Erase on screen: 0 = from the cursor to the end, 1 = from the start to the cursor, 2 = all
+            if (p[0] == 0) vt_erase(vt, index, vt->rows * vt->cols - 1);
+            else if (p[0] == 1) vt_erase(vt, 0, index);
+            else vt_erase(vt, 0, vt->rows * vt->cols - 1);
+            break;
+
+        case 'K':   // Erase on line: 0 = from the cursor to the end, 1 = from the start to the cursor, 2 = all
+            if (p[0] == 0) vt_erase(vt, index, index + (vt->cols - cur.col));
+            else if (p[0] == 1) vt_erase(vt, index - (cur.col - 1), index);
+            else vt_erase(vt, index - (cur.col - 1), index + (vt->cols - cur.col));
+            break;
+
+        case 'b':   // Repeat the previous character
+            for (long i = 0; i < n; i++) vt_print(vt, &vt->last_char);
+            break;
+
+        case 'm':   // Text and background colors
+            if (count == 0) vt_set_color(vt, 0);
+            for (size_t i = 0; i < count; i++) vt_set_color(vt, p[i]);
+            break;
+
+        case 'c':   // Queries and window operations
+        case 'n':
+        case 't':
+            break;
+
+        default:
+            vt->total_unknown++;
+            break;
+    }
+}
+
+// Create an emulated terminal of the given size, with all cells blank
+VtEmulator* vt_create(size_t rows, size_t cols)
+{
+    if (rows == 0 || cols == 0)
+    {
+        printf_error_exit(ERR_INVALID_ARGS, "Emulated terminal must not have an width or a height of zero.");
+    }
+
+    VtEmulator *vt = xmalloc(sizeof(VtEmulator));
+    vt->rows = rows;
+    vt->cols = cols;
+    vt->cells = xmalloc(sizeof(ScreenCell) * rows * cols);
+    vt_erase(vt, 0, rows * cols - 1);
+
+    vt->cursor = (GameCoord){1, 1};
+    vt->saved_cursor = (GameCoord){1, 1};
+    vt->color = CELL_GRAY;
+    vt->last_char = CELL(" ", CELL_GRAY);
+    vt->cursor_visible = true;
+
+    return vt;
+}
+
+// Process the bytes sent to the emulated terminal
+// Note: an escape sequence or an UTF-8 character may be split across calls.
+void vt_feed(VtEmulator *vt, const char *bytes, size_t size)
+{
+    vt->total_bytes += size;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        const unsigned char byte = bytes[i];
+
+        switch (vt->state)
+        {
+            case VT_GROUND:
+                // Continuation of an UTF-8 character
+                if (vt->utf8_needed > 0 && (byte & 0xC0) == 0x80)
+                {
+                    vt->utf8[vt->utf8_size++] = byte;
+                    if (vt->utf8_size == vt->utf8_needed)
+                    {
+                        vt_print_utf8(vt);
+                        vt->utf8_needed = 0;
+                    }
+                    break;
+                }
+                vt->utf8_needed = 0;    // An incomplete UTF-8 character is dropped
+
+                if (byte >= 0x80)
+                {
+                    // Start of an UTF-8 character (the amount of leading 1 bits is the amount of bytes)
+                    if ((byte & 0xE0) == 0xC0) vt->utf8_needed = 2;
+                    else if ((byte & 0xF0) == 0xE0) vt->utf8_needed = 3;
+                    else if ((byte & 0xF8) == 0xF0) vt->utf8_needed = 4;
+                    vt->utf8[0] = byte;
+                    vt->utf8_size = 1;
+                }
+                else if (byte >= 0x20 && byte != 0x7F)
+                {
+                    vt->utf8[0] = byte;
+                    vt->utf8_size = 1;
+                    vt_print_utf8(vt);
+                }
+                else switch (byte)
+                {
+                    case '\x1b':
+                        vt->state = VT_ESCAPE;
+                        vt->total_sequences++;
+                        break;
+
+                    case '\r':
+                        vt_move(vt, vt->cursor.row, 1);
+                        break;
+
+                    case '\n':
+                        vt_line_feed(vt);
+                        break;
+
+                    case '\b':
+                        vt_move(vt, vt->cursor.row, (long)vt->cursor.col - 1);
+                        break;
+
+                    case '\x0e':    // Shift Out: switch to the G1 character set
+                        vt->shift_out = true;
+                        break;
+
+                    case '\x0f':    // Shift In: switch back to the G0 character set
+                        vt->shift_out = false;
+                        break;
+
+                    default:    // Other control characters (like the bell) do not change the screen
+                        break;
+                }
+                break;
+
+            case VT_ESCAPE:
+                vt->state = VT_GROUND;
+                switch (byte)
+                {
+                    case '[':
+                        vt->state = VT_CSI;
+                        vt->params_size = 0;
+                        break;
+
+                    case ']':
+                        vt->state = VT_OSC;
+                        break;
+
+                    case '(':
+                    case ')':
+                        vt->state = VT_CHARSET;
+                        vt->charset_slot = (byte == ')');
+                        break;
+
+                    case 'D':   // Index: move down by one row
+                        vt_line_feed(vt);
+                        break;
+
+                    case 'E':   // Next line: move to the start of the next row
+                        vt_line_feed(vt);
+                        vt->cursor.col = 1;
+                        break;
+
+                    case 'M':   // Reverse index: move up by one row
+                        vt_move(vt, (long)vt->cursor.row - 1, vt->cursor.col);
+                        break;
+
+                    case '=':   // Keypad modes
+                    case '>':
+                    case '\\':  // String terminator
+                        break;
+
+                    default:
+                        vt->total_unknown++;
+                        break;
+                }
+                break;
+
+            case VT_CSI:
+                if (byte >= 0x40 && byte <= 0x7E)
+                {
+                    vt_dispatch_csi(vt, byte);
+                    vt->state = VT_GROUND;
+                }
+                else if (vt->params_size < sizeof(vt->params))
+                {
+                    vt->params[vt->params_size++] = byte;
+                }
+                break;
+
+            case VT_OSC:
+                // Operating system commands (like the window's title) end with BEL or ESC \ (String Terminator)
+                if (byte == '\x07') vt->state = VT_GROUND;
+                else if (byte == '\x1b') vt->state = VT_ESCAPE;
+                break;
+
+            case VT_CHARSET:
+                vt->charset_dec[vt->charset_slot] = (byte == '0');
+                vt->state = VT_GROUND;
+                break;
+        }
+    }
+}
+
+// Function with the signature of OutputSink, for passing an output buffer's bytes to an emulated terminal
+// The emulated terminal takes all bytes right away, so nothing is ever queued.
+// Example: output_set_sink(&screen->out, &vt_sink, vt)
+size_t vt_sink(void *vt, const char *bytes, size_t size, size_t *queued)
+{
+    vt_feed((VtEmulator*)vt, bytes, size);
+    *queued = 0;
+    return size;
+}
+
+// Get the cell at the given position of the emulated terminal
+// Returns NULL if the coordinate is outside of the screen.
+const ScreenCell* vt_cell(const VtEmulator *vt, GameCoord pos)
+{
+    if (pos.row < 1 || pos.row > vt->rows || pos.col < 1 || pos.col > vt->cols) return NULL;
+    return &vt->cells[(pos.row - 1) * vt->cols + (pos.col - 1)];
+}
+
+// Count how many cells of the emulated terminal differ from the given cells
+// 'cells' must have the same size as the emulated terminal (like the front buffer of a ScreenBuffer).
+// Note: the color of blank spaces is not compared, since it does not change how they look.
+//       If the screen uses DEC Special Graphics, its cells are going to differ from the ones displayed by the terminal.
+size_t vt_compare(const VtEmulator *vt, const ScreenCell *cells)
+{
+    size_t mismatches = 0;
+    for (size_t i = 0; i < vt->rows * vt->cols; i++)
+    {
+        const ScreenCell *a = &vt->cells[i];
+        const ScreenCell *b = &cells[i];
+        const bool is_blank = (a->size == 1 && a->glyph[0] == ' ');
+        if (
+            a->size != b->size ||
+            memcmp(a->glyph, b->glyph, a->size) != 0 ||
+            (!is_blank && a->color != b->color)
+        ) mismatches++;
+    }
+
+    return mismatches;
+}
+
+// Save the characters of the emulated terminal to a text file (one line per row)
+// This can be used as a golden frame, for comparing against the output of future versions (see vt_matches_file()).
+// Returns whether the file was saved.
+bool vt_save(const VtEmulator *vt, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+
+    for (size_t row = 0; row < vt->rows; row++)
+    {
+        for (size_t col = 0; col < vt->cols; col++)
+        {
+            const ScreenCell *cell = &vt->cells[row * vt->cols + col];
+            fwrite(cell->glyph, 1, cell->size, file);
+        }
+        fputc('\n', file);
+    }
+
+    return (fclose(file) == 0);
+}
+
+// Check whether the characters of the emulated terminal are the same as on a text file saved by vt_save()
+// Returns false if the file could not be opened.
+bool vt_matches_file(const VtEmulator *vt, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    bool matches = true;
+    char glyph[sizeof(vt->cells->glyph)];
+    for (size_t row = 0; row < vt->rows && matches; row++)
+    {
+        for (size_t col = 0; col < vt->cols && matches; col++)
+        {
+            const ScreenCell *cell = &vt->cells[row * vt->cols + col];
+            matches = (fread(glyph, 1, cell->size, file) == cell->size && memcmp(glyph, cell->glyph, cell->size) == 0);
+        }
+        if (matches) matches = (fgetc(file) == '\n');
+    }
+
+    // Nothing should be left on the file
+    if (matches) matches = (fgetc(file) == EOF);
+
+    fclose(file);
+    return matches;
+}
+
+// Free the memory used by an emulated terminal
+void vt_destroy(VtEmulator *vt)
+{
+    if (!vt) return;
+    free(vt->cells);
+    free(vt);
+}
+
+// (debugging) Draw the given amount of frames of a moving snake, sending the output to an emulated terminal
+// The amount of bytes per frame and the frame rate are printed, along with how many cells were drawn wrong.
+void vt_benchmark(size_t rows, size_t cols, size_t frames)
+{
+    if (rows < 8 || cols < 8) return;
+
+    VtEmulator *vt = vt_create(rows, cols);
+    ScreenBuffer *screen = screen_create(rows, cols);
+    output_set_sink(&screen->out, &vt_sink, vt);
+    screen->sync_output = true;
+    screen->has_rep = true;
+
+    // Board and label
+    const GameCoord board_start = {SCREEN_MARGIN + 1, SCREEN_MARGIN + 1};
+    const GameCoord board_end = {rows - SCREEN_MARGIN, cols - SCREEN_MARGIN};
+    screen_static_box(screen, board_start, board_end, CELL_GRAY);
+    screen_static_text(screen, (GameCoord){rows, SCREEN_MARGIN + 1}, HUD_SIZE_LABEL, CELL_GRAY);
+    screen_redraw(screen);
+    screen_flush(screen, true);
+
+    // The snake goes back and forth along the rows inside the board, and its length stays the same
+    const size_t length = 2 * SNAKE_START_SIZE;
+    GameCoord *body = xmalloc(sizeof(GameCoord) * length);
+    GameCoord pos = {board_start.row + 1, board_start.col + 1};
+    SnakeDirection dir = DIR_RIGHT;
+    size_t head = 0;
+    body[head] = pos;
+    size_t mismatches = 0;
+
+    const uint64_t start_time = clock_usec();
+    const uint64_t start_bytes = screen->out.total_bytes;
+
+    for (size_t frame = 0; frame < frames; frame++)
+    {
+        // Erase the tail
+        // (the positions that were not used yet are zero, which are outside of the screen)
+        screen_set(screen, body[(head + 1) % length], CELL(" ", CELL_GRAY));
+
+        // Turn down at the board's sides, then turn to the opposite side
+        SnakeDirection new_dir = dir;
+        if (dir == DIR_DOWN) new_dir = (pos.col == board_start.col + 1) ? DIR_RIGHT : DIR_LEFT;
+        else if (dir == DIR_RIGHT && pos.col == board_end.col - 1) new_dir = DIR_DOWN;
+        else if (dir == DIR_LEFT && pos.col == board_start.col + 1) new_dir = DIR_DOWN;
+        if (new_dir == DIR_DOWN && pos.row == board_end.row - 1)
+        {
+            // Start over from the top once the bottom is reached
+            new_dir = dir;
+            screen_set(screen, pos, snake_body_cells[dir][new_dir]);
+            pos = (GameCoord){board_start.row + 1, (dir == DIR_RIGHT) ? board_end.col - 1 : board_start.col + 1};
+            new_dir = dir = (dir == DIR_RIGHT) ? DIR_LEFT : DIR_RIGHT;
+        }
+        else
+        {
+            screen_set(screen, pos, snake_body_cells[dir][new_dir]);
+            move_coord(&pos, new_dir, 1);
+            dir = new_dir;
+        }
+
+        head = (head + 1) % length;
+        body[head] = pos;
+        screen_set(screen, pos, snake_head_cells[false][dir]);
+
+        char size_text[24];
+        snprintf(size_text, sizeof(size_text), "%zu", frame);
+        screen_text(screen, (GameCoord){rows, SCREEN_MARGIN + sizeof(HUD_SIZE_LABEL)}, size_text, CELL_WHITE);
+
+        screen_flush(screen, false);
+        if (vt_compare(vt, screen->front) > 0) mismatches++;
+    }
+
+    const uint64_t elapsed = clock_usec() - start_time;
+    const uint64_t bytes = screen->out.total_bytes - start_bytes;
+
+    printf(
+        "Emulated terminal: %zu x %zu\n"
+        "Frames drawn: %zu\n"
+        "Frames per second: %.0f\n"
+        "Bytes per frame: %.1f\n"
+        "Frames with wrong cells: %zu\n"
+        "Unknown sequences: %" PRIu64 "\n",
+        rows, cols,
+        frames,
+        (elapsed > 0) ? (double)frames * 1000000.0 / elapsed : 0.0,
+        (frames > 0) ? (double)bytes / frames : 0.0,
+        mismatches,
+        vt->total_unknown
+    );
+
+    free(body);
+    screen_destroy(screen);
+    vt_destroy(vt);
+}
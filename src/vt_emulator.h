@@ -0,0 +1,81 @@
+// Minimal terminal emulator for checking the game's output without a real terminal (debugging)
+
+#pragma once
+
+#include "includes.h"
+
+#define VT_PARAM_MAX 65535  // Biggest value of a numeric parameter of a control sequence (bigger values are clamped to it)
+
+// State of the parser of the byte stream
+typedef enum VtParserState {VT_GROUND=0, VT_ESCAPE, VT_CSI, VT_OSC, VT_CHARSET} VtParserState;
+
+// Emulated terminal screen
+// Note: the cells are stored row by row, and (row, col) coordinates passed to the functions are 1-indexed.
+typedef struct VtEmulator
+{
+    ScreenCell *cells;      // Characters on the screen (the .dirty field is not used)
+    size_t rows;            // Amount of rows on the screen
+    size_t cols;            // Amount of columns on the screen
+    GameCoord cursor;       // Position of the cursor
+    GameCoord saved_cursor; // Position of the cursor when the alternate screen was entered
+    bool wrap_pending;      // Whether the cursor is past the last column, so the next character goes to the next line
+    uint8_t color;          // Current text color (a value of CellColor)
+    ScreenCell last_char;   // Last printed character (it is printed again by the REP sequence)
+    bool alt_screen;        // Whether the alternate screen is being shown
+    bool cursor_visible;    // Whether the cursor is being displayed
+    bool sync_output;       // Whether a synchronized update is in progress
+    bool charset_dec[2];    // Whether the G0 and G1 character sets are designated as DEC Special Graphics
+    bool shift_out;         // Whether the G1 character set is in use (instead of G0)
+
+    // Parser
+    VtParserState state;    // What the next byte is part of
+    char params[32];        // Parameter and intermediate bytes of the current control sequence
+    size_t params_size;     // Amount of bytes on .params[]
+    int charset_slot;       // Character set being designated (0 for G0, 1 for G1)
+    char utf8[4];           // Bytes of the UTF-8 character being received
+    size_t utf8_size;       // Amount of bytes on .utf8[]
+    size_t utf8_needed;     // Total amount of bytes of the UTF-8 character being received
+
+    // Statistics
+    uint64_t total_bytes;       // Amount of bytes received
+    uint64_t total_sequences;   // Amount of escape sequences received
+    uint64_t total_unknown;     // Amount of escape sequences that were not understood
+} VtEmulator;
+
+// Create an emulated terminal of the given size, with all cells blank
+VtEmulator* vt_create(size_t rows, size_t cols);
+
+// Process the bytes sent to the emulated terminal
+// Note: an escape sequence or an UTF-8 character may be split across calls.
+void vt_feed(VtEmulator *vt, const char *bytes, size_t size);
+
+// Function with the signature of OutputSink, for passing an output buffer's bytes to an emulated terminal
+// The emulated terminal takes all bytes right away, so nothing is ever queued.
+// Example: output_set_sink(&screen->out, &vt_sink, vt)
+size_t vt_sink(void *vt, const char *bytes, size_t size, size_t *queued);
+
+// Get the cell at the given position of the emulated terminal
+// Returns NULL if the coordinate is outside of the screen.
+const ScreenCell* vt_cell(const VtEmulator *vt, GameCoord pos);
+
+// Count how many cells of the emulated terminal differ from the given cells
+// 'cells' must have the same size as the emulated terminal (like the front buffer of a ScreenBuffer).
+// Note: the color of blank spaces is not compared, since it does not change how they look.
+//       If the screen uses DEC Special Graphics, its cells are going to differ from the ones displayed by the terminal.
+size_t vt_compare(const VtEmulator *vt, const ScreenCell *cells);
+
+// Save the characters of the emulated terminal to a text file (one line per row)
+// This can be used as a golden frame, for comparing against the output of future versions (see vt_matches_file()).
+// Returns whether the file was saved.
+bool vt_save(const VtEmulator *vt, const char *path);
+
+// Check whether the characters of the emulated terminal are the same as on a text file saved by vt_save()
+// Returns false if the file could not be opened.
+bool vt_matches_file(const VtEmulator *vt, const char *path);
+
+// Free the memory used by an emulated terminal
+void vt_destroy(VtEmulator *vt);
+
+// (debugging) Draw the given amount of frames of a moving snake, sending the output to an emulated terminal
+// The amount of bytes per frame and the frame rate are printed, along with how many cells were drawn wrong.
+void vt_benchmark(size_t rows, size_t cols, size_t frames);